@@ -222,7 +222,7 @@ public:
 
 	void init() override
 	{
-		view = entityManager;
+		view = declareView<MeshComponent, AnimationController>();
 	}
 
 	void update() override;
@@ -232,7 +232,10 @@ public:
 class MeshSystem : public ark::SystemT<MeshSystem>, public ark::Renderer {
 public:
 
-	void init() override {}
+	void init() override 
+	{
+		declareAccess<>(); // update-ul nu face nimic
+	}
 
 	void update() override {}
 
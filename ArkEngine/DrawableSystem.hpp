@@ -14,6 +14,7 @@
 #include "ark/ecs/EntityManager.hpp"
 #include "ark/ecs/components/Transform.hpp"
 #include "ark/ecs/Meta.hpp"
+#include "ark/util/TransformBatch.hpp"
 
 #include <vector>
 #include <string>
@@ -194,12 +195,17 @@ as only one set of vertices will be available.
 // TODO de redenumit in RenderingMeshSystem, si/sau Drawable in MeshComponent
 class RenderSystem final : public ark::SystemT<RenderSystem>, public ark::Renderer
 {
-    ark::View<ark::Transform, Drawable> view;
+    ark::View<const ark::Transform, ark::Changed<Drawable>> changedDrawables;
+    ark::View<const ark::Transform, const Drawable> drawables;
 public:
     explicit RenderSystem();
 
     void init() override {
-		view = entityManager.view<ark::Transform, Drawable>();
+		changedDrawables = declareView<const ark::Transform, ark::Changed<Drawable>>();
+		drawables = entityManager.view<const ark::Transform, const Drawable>();
+		// m_hierarchy.update() and getWorldTransform() fill the world cache of the transforms, that's a write
+		declareAccess<ark::Transform>();
+		m_hierarchy.connect(entityManager);
 		//querry.onEntityAdd([this](ark::Entity) { this->m_wantsSorting = true; });
     }
 
@@ -226,6 +232,14 @@ private:
     bool m_wantsSorting;
     sf::Vector2f m_cullingBorder;
     std::uint64_t m_filterFlags;
+    std::vector<ark::EntityId> m_croppedEntities;
+    ark::TransformHierarchy m_hierarchy;
+
+    // culling: the drawables of the current render, with their world bounds computed in one batch
+    std::vector<std::pair<const ark::Transform*, const Drawable*>> m_renderList;
+    ark::AffineBatch m_worldTransforms;
+    ark::RectBatch m_localBounds;
+    ark::RectBatch m_worldBounds;
 
     mutable std::size_t m_lastDrawCount;
     mutable bool m_depthWriteEnabled;
@@ -254,25 +268,48 @@ bool utilRectContains(const sf::Rect<T>& first, const sf::Rect<T>& second)
 
 void RenderSystem::update()
 {
-    for (auto [trans, drawable] : view) {
+    // world matrices of the moved transforms, after this getWorldTransform only reads the cache
+    m_hierarchy.update();
+
+    // only the drawables added or modified since the last update can change their sorting/cropping flags
+    std::atomic<bool> wantsSorting = false;
+    std::atomic<bool> croppingChanged = false;
+    changedDrawables.par_each([&](const ark::Transform&, Drawable& drawable) {
         //auto& drawable = entity.getComponent<Drawable>();
         if (drawable.m_wantsSorting) {
             drawable.m_wantsSorting = false;
-            m_wantsSorting = true;
+            wantsSorting.store(true, std::memory_order_relaxed);
         }
 
         //update cropping area
+        bool wasCropped = drawable.m_cropped;
         drawable.m_cropped = !utilRectContains(drawable.m_croppingArea, drawable.m_localBounds);
+        if (wasCropped || drawable.m_cropped)
+            croppingChanged.store(true, std::memory_order_relaxed);
+    }, 256);
+    if (wantsSorting)
+        m_wantsSorting = true;
+
+    if (croppingChanged) {
+        m_croppedEntities.clear();
+        for (auto [entity, drawable] : drawables.each<ark::Entity, const Drawable>())
+            if (drawable.m_cropped)
+                m_croppedEntities.push_back(entity.getID());
+    }
 
-        if (drawable.m_cropped) {
-            //const auto& xForm = entity.getComponent<ark::Transform>().getWorldTransform();
-            const auto& xForm = trans.getWorldTransform();
-
-            //update world positions
-            drawable.m_croppingWorldArea = xForm.transformRect(drawable.m_croppingArea);
-            drawable.m_croppingWorldArea.top += drawable.m_croppingWorldArea.height;
-            drawable.m_croppingWorldArea.height = -drawable.m_croppingWorldArea.height;
-        }
+    // the world area depends on the parents too (they don't mark the children as changed), so it's recomputed every frame
+    for (auto entity : m_croppedEntities) {
+        auto* trans = entityManager.tryGet<const ark::Transform>(entity);
+        auto* drawable = entityManager.tryGet<Drawable>(entity);
+        if (!trans || !drawable || !drawable->m_cropped)
+            continue; // destroyed since the list was built
+        //const auto& xForm = entity.getComponent<ark::Transform>().getWorldTransform();
+        const auto& xForm = trans->getWorldTransform();
+
+        //update world positions
+        drawable->m_croppingWorldArea = xForm.transformRect(drawable->m_croppingArea);
+        drawable->m_croppingWorldArea.top += drawable->m_croppingWorldArea.height;
+        drawable->m_croppingWorldArea.height = -drawable->m_croppingWorldArea.height;
     }
 
     //do Z sorting
@@ -304,11 +341,25 @@ void RenderSystem::render(sf::RenderTarget& rt)
 
     //glCheck(glEnable(GL_SCISSOR_TEST));
     //glCheck(glDepthFunc(GL_LEQUAL));
-    for (auto [trans, drawable] : this->view) {
+    m_renderList.clear();
+    for (auto [trans, drawable] : drawables)
+        m_renderList.emplace_back(&trans, &drawable);
+
+    // the world matrices are cached by m_hierarchy.update(), only the bounds are computed here
+    m_worldTransforms.resize(m_renderList.size());
+    m_localBounds.resize(m_renderList.size());
+    for (std::size_t i = 0; i < m_renderList.size(); i++) {
+        m_worldTransforms.set(i, m_renderList[i].first->getWorldTransform());
+        m_localBounds.set(i, m_renderList[i].second->getLocalBounds());
+    }
+    ark::transformRects(m_worldTransforms, m_localBounds, m_worldBounds);
+
+    for (std::size_t i = 0; i < m_renderList.size(); i++) {
+        const auto& drawable = *m_renderList[i].second;
         //const auto& drawable = entity.getComponent<Drawable>();
         //const auto& tx = entity.getComponent<ark::Transform>().getWorldTransform();
-        const auto& tx = trans.getWorldTransform();
-        const auto bounds = tx.transformRect(drawable.getLocalBounds());
+        const auto& tx = m_renderList[i].first->getWorldTransform();
+        const auto bounds = m_worldBounds.get(i);
 
         if ((!drawable.m_cull || bounds.intersects(viewableArea))) {
             //&& (drawable.m_filterFlags & m_filterFlags)) {
@@ -92,7 +92,7 @@ public:
 		lua["getComponent"] = [](sol::table selfScript, std::string_view componentName, sol::this_state luaState) mutable -> sol::table {
 			auto mdata = ark::meta::resolve(componentName);
 			auto entity = selfScript["entity"].get<ark::Entity>();
-			void* pComp = entity.get(mdata->type);
+			void* pComp = entity.get(*mdata);
 			auto tableFromPtr = mdata->func<sol::table(sol::state_view, void*)>("lua_table_from_pointer");
 			return tableFromPtr(luaState, pComp);
 		};
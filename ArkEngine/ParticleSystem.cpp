@@ -23,13 +23,14 @@ void PointParticleSystem::update()
 	}
 	*/
 
-	for (auto& ps : view) {
+	auto deltaTime = ark::Engine::deltaTime();
+	auto dt = deltaTime.asSeconds();
+
+	// fiecare PointParticles e independent, deci le updatam in paralel
+	view.par_each([&, this](PointParticles& ps) {
 		//if (ps.areDead())
 			//return;
 
-		auto deltaTime = ark::Engine::deltaTime();
-		auto dt = deltaTime.asSeconds();
-
 		auto vert = ps.vertices.begin();
 		auto data = ps.data.begin();
 		for (; vert != ps.vertices.end() && data != ps.data.end(); ++vert, ++data) {
@@ -71,7 +72,7 @@ void PointParticleSystem::update()
 		//	} else if (ps.spawn)
 		//		respawnPointParticle(ps, ps.vertices[i], ps.data[i].speed, ps.data[i].lifeTime);
 		//}
-	}
+	}, 1);
 }
 
 void PointParticleSystem::render(sf::RenderTarget& target)
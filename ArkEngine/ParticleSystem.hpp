@@ -274,7 +274,7 @@ class PointParticleSystem : public ark::SystemT<PointParticleSystem>, public ark
 public:
 	void init() override
 	{
-		view = entityManager.view<PointParticles>();
+		view = declareView<PointParticles>();
 	}
 
 	static inline sf::Vector2f gravityVector{ 0.f, 0.f };
@@ -296,7 +296,7 @@ class PixelParticleSystem : public ark::SystemT<PixelParticleSystem>, public ark
 public:
 	void init() override
 	{
-		view = entityManager.view<PixelParticles>();
+		view = declareView<PixelParticles>();
 		//querry.onEntityAdd([this](ark::Entity entity) {
 		//	auto& p = entity.getComponent<PixelParticles>();
 		//	if (p.spawn)
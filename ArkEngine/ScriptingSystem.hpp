@@ -18,6 +18,7 @@ public:
 	virtual void handleEvent(const sf::Event& ev) noexcept {}
 	virtual void update() noexcept {}
 
+	// writes through a pointer kept from bind() are not seen by Changed<T> views, only getComponent marks the component as changed
 	template <typename T> T* getComponent() { return mEntity.tryGet<T>(); }
 
 	ark::Entity entity() { return mEntity; }
@@ -311,11 +312,6 @@ public:
 		});
 	}
 
-	void handleMessage(const ark::Message& m) override
-	{
-		// nush
-	}
-
 private:
 	template <typename F>
 	void forEachScript(F f)
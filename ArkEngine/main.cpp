@@ -9,6 +9,7 @@
 #include <thread>
 #include <memory_resource>
 #include <concepts>
+#include <filesystem>
 
 #include <SFML/Graphics.hpp>
 #include <SFML/System/String.hpp>
@@ -19,7 +20,10 @@
 #include <ark/core/Engine.hpp>
 #include <ark/core/State.hpp>
 #include <ark/ecs/EntityManager.hpp>
+#include <ark/ecs/CommandBuffer.hpp>
 #include <ark/ecs/SceneInspector.hpp>
+#include <ark/ecs/TimerSystem.hpp>
+#include <ark/ecs/PrefabLibrary.hpp>
 #include <ark/util/Util.hpp>
 #include <ark/util/RandomNumbers.hpp>
 #include <ark/gui/Gui.hpp>
@@ -198,16 +202,14 @@ class TestMessageSystem : public ark::System {
 public:
 	TestMessageSystem() : ark::System(typeid(TestMessageSystem)) {}
 
-	void handleMessage(const ark::Message& message) override
+	void init() override
 	{
-		if (message.is<Mesajul>()) {
-			const auto& m = message.data<Mesajul>();
+		subscribeMessage<Mesajul>([](const Mesajul& m) {
 			std::cout << "mesaj: " << m.msg << '\n';
-		}
-		if (message.is<PodType>()) {
-			const auto& m = message.data<PodType>();
+		});
+		subscribeMessage<PodType>([](const PodType& m) {
 			std::cout << "int: " << m.i << "\n";
-		}
+		});
 	}
 
 	void update() override
@@ -218,6 +220,49 @@ public:
 	}
 };
 
+// the entities saved in assets/entities, opened once at startup by loadPrefabs()
+auto prefabLibrary() -> ark::PrefabLibrary&
+{
+	static ark::PrefabLibrary library;
+	return library;
+}
+
+/* the library is packed from the json files of the entities the first time and again when one of them
+ * is newer than it, after that the prefabs are instantiated from the mapped file without parsing json
+*/
+void loadPrefabs()
+{
+	namespace fs = std::filesystem;
+	const auto folder = fs::path(ark::Resources::resourceFolder) / "entities";
+	const auto path = (folder / "prefabs.arkp").string();
+
+	std::error_code ec;
+	std::vector<std::string> names;
+	bool stale = !fs::exists(path, ec);
+	for (const auto& file : fs::directory_iterator(folder, ec)) {
+		if (file.path().extension() != ".json")
+			continue;
+		names.push_back(file.path().stem().string());
+		if (!stale && file.last_write_time(ec) > fs::last_write_time(path, ec))
+			stale = true;
+	}
+	if (!stale && prefabLibrary().open(path))
+		return;
+
+	ark::EntityManager scratch;
+	auto entities = ark::serde::deserializeEntities(scratch, names);
+	std::vector<ark::Entity> prefabs;
+	for (std::size_t i = 0; i < entities.size(); i++) {
+		if (!entities[i])
+			continue;
+		// the prefab is found by the name of the file, not every file has a Tag
+		entities[i].add<TagComponent>().name = names[i];
+		prefabs.push_back(entities[i]);
+	}
+	if (ark::PrefabLibrary::packToFile(prefabs, path) && prefabLibrary().open(path))
+		GameLog("packed %d prefabs in %s", prefabs.size(), path);
+}
+
 class BasicState : public ark::State {
 
 protected:
@@ -285,53 +330,6 @@ public:
 	}
 };
 
-// one time use component, it is removed from its entity after thes action is performed
-struct DelayedAction {
-
-	DelayedAction() = default;
-
-	DelayedAction(sf::Time time, std::function<void(Entity)> fun)
-	{
-		setAction(time, fun);
-	}
-
-	void setAction(sf::Time time, std::function<void(Entity)> fun)
-	{
-		this->time = time;
-		action = std::move(fun);
-	}
-
-private:
-	sf::Time time;
-	std::function<void(Entity)> action;
-
-	friend class DelayedActionSystem;
-};
-ARK_REGISTER_COMPONENT(DelayedAction, registerServiceDefault<DelayedAction>()) { return members<DelayedAction>(); }
-
-class DelayedActionSystem : public ark::SystemT<DelayedActionSystem> {
-	ark::View<DelayedAction> view;
-public:
-	void init() override
-	{
-		view = entityManager.view<DelayedAction>();
-	}
-
-	void update() override
-	{
-		for (auto [entity, da] : view.each()) {
-			da.time -= Engine::deltaTime();
-			if (da.time <= sf::Time::Zero) {
-				if (da.action) {
-					auto action = std::move(da.action);
-					entity.remove<DelayedAction>();
-					action(entity);
-				}
-			}
-		}
-	}
-};
-
 class SaveEntityScript : public ScriptT<SaveEntityScript> {
 public:
 	SaveEntityScript() = default;
@@ -438,7 +436,7 @@ private:
 		systems.addSystem<TextSystem>();
 		systems.addSystem<MeshSystem>();
 		systems.addSystem<AnimationSystem>();
-		systems.addSystem<DelayedActionSystem>();
+		auto* timers = systems.addSystem<ark::TimerSystem>();
 		systems.addSystem<ScriptingSystem>();
 		systems.addSystem<CameraSystem>();
 
@@ -456,6 +454,8 @@ private:
 		greenPointParticles = makeEntity("green_ps");
 		firePointParticles = makeEntity("fire_ps");
 		rotatingParticles = makeEntity("rotating_ps");
+		if (prefabLibrary().contains("player2"))
+			prefabLibrary().instantiate(manager, "player2");
 
 		player = makeEntity("player");
 		//ark::serde::deserializeEntity(player);
@@ -486,7 +486,7 @@ private:
 
 			moveScript->setScale({ 0.2f, 0.2f });
 
-			//player.add<DelayedAction>(sf::seconds(4), [](Entity e) {
+			//timers->after(player, sf::seconds(4), [](Entity e) {
 			//	GameLog("just serialized entity %s", e.getComponent<TagComponent>().name);
 			//	ark::serde::serializeEntity(e);
 			//});
@@ -532,7 +532,7 @@ private:
 			//scripts.addScript<SpawnOnLeftClick>()->setActive(false);
 			//scripts.addScript<EmittFromMouse>();
 		}
-		rainbowClone.add<DelayedAction>(sf::seconds(5), [](ark::Entity entity) {
+		timers->after(rainbowClone, sf::seconds(5), [](ark::Entity entity) {
 			entity.get<ScriptingComponent>().getScript<SpawnOnRightClick>()->setActive(true);
 		});
 #endif
@@ -543,7 +543,7 @@ private:
 			scripts.addScript<SpawnOnLeftClick>();
 			scripts.addScript<EmittFromMouse>();
 		}
-		firePointParticles.add<DelayedAction>(sf::seconds(5), [this](ark::Entity e) {
+		timers->after(firePointParticles, sf::seconds(5), [this](ark::Entity e) {
 			manager.destroyEntity(e);
 		});
 
@@ -717,7 +717,7 @@ struct ChessPlayerComponent {
 //	ark::meta::member_property("id", &ChessPlayerComponent::id)
 //);
 
-ARK_REGISTER_COMPONENT(ChessPlayerComponent, registerServiceDefault<ChessPlayerComponent>()) { 
+ARK_REGISTER_COMPONENT(ChessPlayerComponent, registerServiceDefault<ChessPlayerComponent>(), registerServicePrefabRaw<ChessPlayerComponent>()) { 
 	return members<ChessPlayerComponent>(ark::meta::member_property("id", &ChessPlayerComponent::id)); 
 }
 
@@ -746,7 +746,7 @@ ARK_REGISTER_COMPONENT(ChessPieceComponent, registerServiceDefault<ChessPieceCom
 	return members<ChessPieceComponent>(
 	); 
 }
-ARK_REGISTER_COMPONENT(ChessEnPassantTag, registerServiceDefault<ChessEnPassantTag>()) { 
+ARK_REGISTER_COMPONENT(ChessEnPassantTag, registerServiceDefault<ChessEnPassantTag>(), registerServicePrefabRaw<ChessEnPassantTag>()) { 
 	return members<ChessEnPassantTag>(
 	); 
 }
@@ -763,7 +763,7 @@ struct MousePickUpComponent {
 	bool drag = true;
 };
 
-ARK_REGISTER_COMPONENT(MousePickUpComponent, registerServiceDefault<MousePickUpComponent>()) { 
+ARK_REGISTER_COMPONENT(MousePickUpComponent, registerServiceDefault<MousePickUpComponent>(), registerServicePrefabRaw<MousePickUpComponent>()) { 
 	return members<MousePickUpComponent>(
 		member_property("selectArea", &MousePickUpComponent::selectArea)
 	); 
@@ -781,10 +781,17 @@ class MousePickUpSystem : public ark::SystemT<MousePickUpSystem> {
 	int m_genFlags = 1;
 	ark::Entity selectedEntity;
 	ark::View<const ark::Transform, MousePickUpComponent> view;
+	ark::View<ark::Changed<const ark::Transform>, MousePickUpComponent> moved;
+	ark::View<const ark::Transform, ark::Added<MousePickUpComponent>> added;
 
 public:
 	void init() override {
 		view = entityManager.view<const ark::Transform, MousePickUpComponent>();
+		moved = declareView<ark::Changed<const ark::Transform>, MousePickUpComponent>();
+		added = declareView<const ark::Transform, ark::Added<MousePickUpComponent>>();
+		// update muta Transform-ul entitatii selectate dupa mouse
+		declareAccess<ark::Transform, MousePickUpComponent>();
+		setMainThreadOnly();
 	}
 
 	void setFilter(int bitFlags = 0) { filters = bitFlags; }
@@ -859,12 +866,13 @@ public:
 				trans.setPosition(x - pick.dx, y - pick.dy);
 			}
 		}
-		// update-ul are sens doar pentru cele cu Transform-ul modificat
-		// TODO (ecs) poate adaug un flag m_dirty pentru componente cand le acceses prin ref, fara flag cand sunt 'const'
-		for (auto [trans, pick] : view) {
+		// update-ul are sens doar pentru cele cu Transform-ul modificat (inclusiv de mai sus) sau adaugate de la ultimul update
+		auto updateArea = [](const ark::Transform& trans, MousePickUpComponent& pick) {
 			pick.selectArea.left = trans.getPosition().x;
 			pick.selectArea.top = trans.getPosition().y;
-		}
+		};
+		moved.each(updateArea);
+		added.each(updateArea);
 	}
 };
 
@@ -1114,11 +1122,9 @@ public:
 			systemManager.getSystem<MousePickUpSystem>()->setFilter(0);
 			return;
 		}
-		auto it = std::find(playersQuery.begin(), playersQuery.end(), playerInTurn);
-		if (it == playersQuery.end() - 1)
-			playerInTurn = *playersQuery.begin();
-		else
-			playerInTurn = *std::next(it);
+		// indexOf e ArkInvalidIndex (-1) daca playerInTurn nu e in query, atunci incepe primul
+		auto index = playersQuery.indexOf(playerInTurn);
+		playerInTurn = playersQuery[(index + 1) % playersQuery.size()];
 		auto id = playerInTurn.get<ChessPlayerComponent>().id;
 		systemManager.getSystem<MousePickUpSystem>()->setFilter(id);
 	}
@@ -1131,6 +1137,7 @@ public:
 		playersQuery.connect(entityManager);
 
 		netSystem = systemManager.getSystem<NetworkSystem>();
+		subscribeMessage<MessagePickUp>(&ChessSystem::onPickUp, this);
 		netSystem->addHandle(Operation::Move, [this](sf::Packet& packet) {
 			sf::Vector2i newCoord;
 			packet >> newCoord.x >> newCoord.y;
@@ -1218,15 +1225,17 @@ public:
 			entityManager.destroyEntity(board[newCoord.x][newCoord.y]);
 		[[fallthrough]];
 		// move
-		case BoxType::Empty:
+		case BoxType::Empty: {
+			ark::CommandBuffer enPassant{ entityManager };
 			entityManager.view<ChessEnPassantTag>().each([&](ark::Entity markedEntity, ChessEnPassantTag& enpass) {
 				if (selectedPiece.get<ChessPieceComponent>().player != markedEntity.get<ChessPieceComponent>().player) {
 					if (newCoord == enpass.behindCoord) // daca am pus pionul in spate
-						entityManager.destroyEntity(markedEntity);
+						enPassant.destroyEntity(markedEntity);
 					else
-						markedEntity.remove<ChessEnPassantTag>();
+						enPassant.remove<ChessEnPassantTag>(markedEntity);
 				}
 			});
+			enPassant.playback();
 			trans.setPosition(toPos(newCoord));
 			board[piece.coord.x][piece.coord.y] = {};
 			board[newCoord.x][newCoord.y] = selectedPiece;
@@ -1234,6 +1243,7 @@ public:
 			nextPlayerTurn();
 			break;
 		}
+		}
 		selectedPiece = {};
 	}
 
@@ -1249,28 +1259,25 @@ public:
 			movesToDraw = piece.generateMoves(piece.coord);
 	}
 
-	void handleMessage(const ark::Message& msg) override {
-		if (auto* data = msg.tryData<MessagePickUp>(); !data) {
-			return;
-		}
+	void onPickUp(const MessagePickUp& pickUp) {
 		// un-select
-		else if (data->isSameSpot) {
+		if (pickUp.isSameSpot) {
 			selectedPiece = {};
 			netSystem->send([&](sf::Packet& packet) {
 				packet << (int)Operation::UnSelect;
 			});
 		}
 		// selected
-		else if (!data->isReleased) { 
-			handlePieceSelect(data->entity);
-			auto [x, y] = data->entity.get<ChessPieceComponent>().coord;
+		else if (!pickUp.isReleased) { 
+			handlePieceSelect(pickUp.entity);
+			auto [x, y] = pickUp.entity.get<ChessPieceComponent>().coord;
 			netSystem->send([&](sf::Packet& packet) {
 				packet << (int)Operation::Select << x << y;
 			});
 		}
 		// try to moves
-		else if (data->isReleased) { 
-			sf::Vector2i newCoord = toCoord(data->mousePosition);
+		else if (pickUp.isReleased) { 
+			sf::Vector2i newCoord = toCoord(pickUp.mousePosition);
 			handlePieceMove(newCoord);
 			netSystem->send([&](sf::Packet& packet) {
 				packet << (int)Operation::Move << newCoord.x << newCoord.y;
@@ -1490,7 +1497,7 @@ struct FilterComponent {
 
 template <typename F>
 void forFilter(ark::EntityManager& man, FilterComponent filter, F&& fun) {
-	man.view<FilterComponent>().each([&](ark::Entity entity, FilterComponent& comp) {
+	man.view<const FilterComponent>().each([&](ark::Entity entity, const FilterComponent& comp) {
 		const bool all = (comp.flagsAll & filter.flagsAll) == filter.flagsAll;
 		const bool exc = !(comp.flagsNone & filter.flagsNone);
 		if (all & exc) {
@@ -1767,6 +1774,8 @@ int main() // are nevoie de c++17 si SFML 2.5.1
 	Engine::backGroundColor = sf::Color(50, 50, 50);
 	Engine::getWindow().setVerticalSyncEnabled(false);
 
+	loadPrefabs();
+
 	Engine::registerState<TestingState>();
 	Engine::registerState<ImGuiLayer>();
 	Engine::registerState<ChessState>();
@@ -38,6 +38,9 @@ namespace ark {
 		Resources::addHandler<sf::Texture>("textures", Resources::load_SFML_resource<sf::Texture>);
 		Resources::addHandler<sf::Font>("fonts", Resources::load_SFML_resource<sf::Font>);
 		Resources::addHandler<sf::Image>("imags", Resources::load_SFML_resource<sf::Image>);
+
+		// tipurile inregistrate static sunt gata, meta::resolve(name) nu mai trebuie sa construiasca tabelul
+		ark::meta::buildNameTable();
 	}
 
 	MessageBus Engine::messageBus;
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <memory>
+
+#include "ark/core/Core.hpp"
+#include "ark/util/Util.hpp"
+
+namespace ark {
+
+	/* Thread pool cu work-stealing
+	 *
+	 * Fiecare worker are coada lui: ia job-uri de la coada proprie (LIFO) si, cand e goala, fura de la
+	 * inceputul cozilor celorlalti. Thread-urile din afara pool-ului (main thread) folosesc o coada in plus
+	 * si ajuta la executie pana cand job-urile lor se termina, deci parallelFor e blocant.
+	 *
+	 * Pool-ul engine-ului e JobSystem::global(), creat la prima folosire cu hardware_concurrency() - 1 workeri.
+	*/
+	class JobSystem final : public NonCopyable, public NonMovable {
+	public:
+		using Function = void(*)(const void* context, std::size_t begin, std::size_t end);
+		using Counter = std::atomic<std::size_t>; // number of unfinished jobs of a group
+
+		static unsigned defaultWorkerCount()
+		{
+			return std::max(1u, std::thread::hardware_concurrency()) - 1;
+		}
+
+		explicit JobSystem(unsigned workerCount = defaultWorkerCount())
+		{
+			for (unsigned i = 0; i <= workerCount; i++)
+				m_queues.push_back(std::make_unique<Queue>());
+			for (unsigned i = 0; i < workerCount; i++)
+				m_workers.emplace_back([this, i]() { this->workerLoop(i); });
+		}
+
+		~JobSystem()
+		{
+			{
+				std::scoped_lock lock(m_sleepMutex);
+				m_stop = true;
+			}
+			m_wake.notify_all();
+			for (auto& worker : m_workers)
+				worker.join();
+		}
+
+		static JobSystem& global()
+		{
+			static JobSystem s_jobSystem;
+			return s_jobSystem;
+		}
+
+		auto workerCount() const -> unsigned { return static_cast<unsigned>(m_workers.size()); }
+
+		// [0, workerCount()) on worker threads, workerCount() on every other thread
+		auto threadIndex() const -> std::size_t { return currentQueue(); }
+
+		/* splits [0, count) in ranges of at most 'grain' elements and calls fun(begin, end) for each one
+		 * 'fun' is called concurrently from several threads
+		 * the calling thread runs jobs too and returns after every range is done
+		*/
+		template <typename F>
+		void parallelFor(std::size_t count, std::size_t grain, F&& fun)
+		{
+			if (count == 0)
+				return;
+			grain = std::max<std::size_t>(grain, 1);
+			const std::size_t jobCount = (count + grain - 1) / grain;
+			if (jobCount == 1 || m_workers.empty()) {
+				fun(std::size_t{ 0 }, count);
+				return;
+			}
+
+			using Fun = std::remove_reference_t<F>;
+			Function trampoline = [](const void* context, std::size_t begin, std::size_t end) {
+				(*static_cast<Fun*>(const_cast<void*>(context)))(begin, end);
+			};
+
+			Counter pending = jobCount;
+			{
+				auto& queue = *m_queues[currentQueue()];
+				std::scoped_lock lock(queue.mutex);
+				for (std::size_t begin = 0; begin < count; begin += grain)
+					queue.jobs.push_back({ trampoline, &fun, begin, std::min(begin + grain, count), &pending });
+			}
+			notifyPushed(jobCount);
+			wait(pending);
+		}
+
+		/* queues function(context, begin, end) on the calling thread's queue
+		 * 'counter' is incremented now and decremented after the job ran, 'context' must outlive the job
+		*/
+		void push(Function function, const void* context, std::size_t begin, std::size_t end, Counter& counter)
+		{
+			counter.fetch_add(1, std::memory_order_relaxed);
+			{
+				auto& queue = *m_queues[currentQueue()];
+				std::scoped_lock lock(queue.mutex);
+				queue.jobs.push_back({ function, context, begin, end, &counter });
+			}
+			notifyPushed(1);
+		}
+
+		// runs one queued job, if there is any
+		bool tryRunJob()
+		{
+			Job job;
+			if (!tryGetJob(currentQueue(), job))
+				return false;
+			run(job);
+			return true;
+		}
+
+		// runs jobs on the calling thread until 'counter' reaches 0
+		void wait(const Counter& counter)
+		{
+			while (counter.load(std::memory_order_acquire) != 0) {
+				if (!tryRunJob())
+					std::this_thread::yield();
+			}
+		}
+
+	private:
+		struct Job {
+			Function function = nullptr;
+			const void* context = nullptr;
+			std::size_t begin = 0;
+			std::size_t end = 0;
+			Counter* pending = nullptr;
+		};
+
+		struct Queue {
+			std::mutex mutex;
+			std::deque<Job> jobs;
+		};
+
+		void workerLoop(unsigned index)
+		{
+			t_owner = this;
+			t_queue = index;
+			while (true) {
+				Job job;
+				if (tryGetJob(index, job)) {
+					run(job);
+					continue;
+				}
+				std::unique_lock lock(m_sleepMutex);
+				m_wake.wait(lock, [this]() { return m_stop || m_queued.load(std::memory_order_acquire) != 0; });
+				if (m_stop)
+					return;
+			}
+		}
+
+		// own queue from the back, then steal from the front of the others
+		bool tryGetJob(std::size_t index, Job& job)
+		{
+			if (m_queued.load(std::memory_order_acquire) == 0)
+				return false;
+			{
+				auto& queue = *m_queues[index];
+				std::scoped_lock lock(queue.mutex);
+				if (!queue.jobs.empty()) {
+					job = queue.jobs.back();
+					queue.jobs.pop_back();
+					m_queued.fetch_sub(1, std::memory_order_relaxed);
+					return true;
+				}
+			}
+			for (std::size_t i = 1; i < m_queues.size(); i++) {
+				auto& queue = *m_queues[(index + i) % m_queues.size()];
+				std::scoped_lock lock(queue.mutex);
+				if (!queue.jobs.empty()) {
+					job = queue.jobs.front();
+					queue.jobs.pop_front();
+					m_queued.fetch_sub(1, std::memory_order_relaxed);
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void notifyPushed(std::size_t count)
+		{
+			m_queued.fetch_add(count, std::memory_order_release);
+			{
+				std::scoped_lock lock(m_sleepMutex);
+			}
+			m_wake.notify_all();
+		}
+
+		static void run(const Job& job)
+		{
+			job.function(job.context, job.begin, job.end);
+			job.pending->fetch_sub(1, std::memory_order_release);
+		}
+
+		// workers use their own queue, every other thread uses the last one
+		auto currentQueue() const -> std::size_t
+		{
+			return t_owner == this ? t_queue : m_queues.size() - 1;
+		}
+
+	private:
+		std::vector<std::unique_ptr<Queue>> m_queues; // m_workers.size() + 1
+		std::vector<std::thread> m_workers;
+		std::atomic<std::size_t> m_queued = 0;
+		std::mutex m_sleepMutex;
+		std::condition_variable m_wake;
+		bool m_stop = false;
+
+		static inline thread_local const JobSystem* t_owner = nullptr;
+		static inline thread_local std::size_t t_queue = 0;
+	};
+}
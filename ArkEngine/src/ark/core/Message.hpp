@@ -5,6 +5,7 @@
 
 #include <iostream>
 #include <typeindex>
+#include <cstdint>
 
 namespace ark {
 
@@ -33,6 +34,7 @@ namespace ark {
 
 	private:
 		int m_size = 0;
+		std::uint32_t m_id = 0; // dense, routes the message to its subscribers
 		void* m_data = nullptr;
 
 		friend class MessageBus;
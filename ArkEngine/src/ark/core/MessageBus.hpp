@@ -2,113 +2,227 @@
 
 #include "Core.hpp"
 #include "Message.hpp"
+#include "Signal.hpp"
 #include "ark/util/Util.hpp"
 
 #include <vector>
-#include <functional>
+#include <memory>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
 #include <type_traits>
+#include <cstdint>
+#include <cstddef>
 
 namespace ark {
 
+	/* Mesajele postate intr-un frame sunt livrate in urmatorul, de pool()
+	 *
+	 * Mesajele stau intr-o arena de pagini: cand pagina curenta se umple se trece la urmatoarea (alocata
+	 * la nevoie), mesajele deja postate nu se muta, pointerii intorsi de post() raman valizi pana sunt livrate.
+	 * Paginile sunt refolosite de la un frame la altul.
+	 *
+	 * subscribe<T>(handler) apeleaza handler(const T&) doar pentru mesajele de tip T, din pool(), inainte
+	 * ca mesajul sa fie intors. Mesajele sunt intoarse in continuare de pool() pentru handleMessage.
+	 *
+	 * post() poate fi apelat din orice thread (mai multi producatori, un consumator):
+	 * fiecare thread are arena lui, cate una pentru fiecare paritate a frame-ului, post() nu ia lock-uri
+	 * (doar prima data cand un thread posteaza pe bus, ca sa-si inregistreze arena).
+	 * pool() si subscribe() sunt apelate doar de thread-ul consumator (main thread).
+	 * Un thread care posteaza nu mai are voie sa modifice mesajul dupa ce post() a intors, pool() poate
+	 * sa-l livreze oricand dupa aceea; main thread-ul poate, pana la urmatorul pool().
+	 * Mesajele unui thread sunt livrate in ordinea in care au fost postate, intre thread-uri ordinea nu e definita.
+	*/
 	class MessageBus final {
 
 	public:
+		static constexpr std::size_t PageSize = 16 * 1024;
 
-		MessageBus()
-			: inBuffer(128 * 64),
-			outBuffer(128 * 64),
-			inPointer(inBuffer.data()),
-			outPointer(outBuffer.data()),
-			currentCount(0),
-			pendingCount(0),
-			inDestructors(0),
-			outDestructors(0),
-			inDtorCount(0),
-			outDtorCount(0)
-		{}
+		MessageBus() = default;
+		MessageBus(const MessageBus&) = delete;
+		MessageBus& operator=(const MessageBus&) = delete;
+
+		~MessageBus()
+		{
+			for (auto& producer : producers)
+				for (auto& queue : producer->queues)
+					queue.clear();
+		}
 
 		template <typename T, typename... Args>
 		T* post(Args&&... args)
 		{
-			// TODO (message bus): assert ca nu am depasit nr max de bytes
-			Message* message = new(inPointer)Message();
-			inPointer += sizeof(Message);
+			Producer& producer = localProducer();
+			// pool() waits for the producers that are inside post() when it swaps the frames
+			producer.busy.store(true, std::memory_order_seq_cst);
+			Queue& queue = producer.queues[epoch.load(std::memory_order_seq_cst) & 1];
+
+			Message* message = new(queue.allocate(sizeof(Message), alignof(Message)))Message();
 			message->type = typeid(T);
 			message->m_size = sizeof(T);
-			message->m_data = new(inPointer)T(std::forward<Args>(args)...);
-			inPointer += sizeof(T);
-			pendingCount++;
-
-			T* data = static_cast<T*>(message->m_data);
+			message->m_id = messageId<T>();
+			T* data = new(queue.allocate(sizeof(T), alignof(T)))T(std::forward<Args>(args)...);
+			message->m_data = data;
+			queue.messages.push_back(message);
 
-			if constexpr (!std::is_trivially_destructible_v<T>) {
-				// keep count so that we dont always allocate a new function
-				if (inDtorCount == inDestructors.size())
-					inDestructors.push_back([data]() { data->~T(); });
-				else
-					inDestructors.at(inDtorCount) = [data]() { data->~T(); };
+			if constexpr (!std::is_trivially_destructible_v<T>)
+				queue.destructors.push_back({ [](void* data) { static_cast<T*>(data)->~T(); }, data });
 
-				inDtorCount++;
-			}
+			producer.busy.store(false, std::memory_order_release);
 			return data;
 		}
 
 		bool pool(Message*& message)
 		{
-			if (currentCount == 0) {
-				for (int i = 0; i < outDtorCount; i++)
-					outDestructors[i]();
-
-				outDestructors.swap(inDestructors);
-				outDtorCount = inDtorCount;
-				inDtorCount = 0;
-
-				outBuffer.swap(inBuffer);
-				inPointer = inBuffer.data();
-				outPointer = outBuffer.data();
-				currentCount = pendingCount;
-				pendingCount = 0;
+			while (outProducer < consuming.size()) {
+				const auto& queue = consuming[outProducer]->queues[outQueue];
+				if (outIndex < queue.messages.size()) {
+					message = queue.messages[outIndex++];
+					if (message->m_id < handlers.size() && handlers[message->m_id])
+						handlers[message->m_id]->publish(*message);
+					return true;
+				}
+				outProducer++;
+				outIndex = 0;
+			}
 
-				return false;
+			// end of the frame: destroy the delivered messages, their queues are the ones the producers use next
+			for (auto* producer : consuming)
+				producer->queues[outQueue].clear();
+			const auto ended = epoch.fetch_add(1, std::memory_order_seq_cst);
+			outQueue = ended & 1;
+			{
+				std::scoped_lock lock(producersMutex);
+				consuming.clear();
+				for (auto& producer : producers)
+					consuming.push_back(producer.get());
 			}
-			message = reinterpret_cast<Message*>(outPointer);
-			outPointer += (sizeof(Message) + message->m_size);
-			currentCount--;
-			//if(auto funcs = findDelegate(message->type); funcs)
-			//	for (auto& fun : *funcs)
-			//		fun(*message);
-			return true;
+			// the posts that started before the swap finish in the queues delivered next
+			for (auto* producer : consuming)
+				while (producer->busy.load(std::memory_order_seq_cst))
+					std::this_thread::yield();
+			outProducer = 0;
+			outIndex = 0;
+
+			return false;
 		}
 
-		//void addObserver(std::type_index type, std::function<void(const Message&)> func) {
-		//	if (auto funcs = findDelegate(type)) {
-		//		funcs->emplace_back(std::move(func));
-		//	}
-		//	else {
-		//		callbacks.push_back({ type, {std::move(func)} });
-		//	}
-		//}
+		/* handler(payload..., const T&) is called for every message of type T, see Sink::connect
+		 * bus.subscribe<MessagePickUp>(&ChessSystem::onPickUp, this);
+		 * don't subscribe to T from a handler of T
+		*/
+		template <typename T, typename F, typename... Payload>
+		requires std::invocable<F&, Payload&..., const T&>
+		Connection subscribe(F&& handler, Payload&&... payload)
+		{
+			const auto id = messageId<T>();
+			if (id >= handlers.size())
+				handlers.resize(id + 1);
+			if (!handlers[id])
+				handlers[id] = std::make_unique<Signal<void(const Message&)>>();
+
+			auto fun = ark::bind_front(std::forward<F>(handler), std::forward<Payload>(payload)...);
+			return Sink{ *handlers[id] }.connect([fun = std::move(fun)](const Message& message) mutable {
+				fun(*static_cast<const T*>(message.m_data));
+			});
+		}
 
 	private:
+		// pages of PageSize bytes, the bigger messages get a page of their own
+		struct Arena {
+			struct Page {
+				std::unique_ptr<std::byte[]> data;
+				std::size_t size;
+			};
+
+			std::vector<Page> pages;
+			std::size_t page = 0; // the current one
+			std::size_t used = 0; // in the current page
+
+			void* allocate(std::size_t size, std::size_t align)
+			{
+				while (true) {
+					if (page == pages.size()) {
+						const auto pageSize = std::max(PageSize, size + align);
+						pages.push_back({ std::unique_ptr<std::byte[]>(new std::byte[pageSize]), pageSize });
+						used = 0;
+					}
+					auto& current = pages[page];
+					const auto base = reinterpret_cast<std::uintptr_t>(current.data.get());
+					const auto offset = ((base + used + align - 1) & ~(align - 1)) - base;
+					if (offset + size <= current.size) {
+						used = offset + size;
+						return current.data.get() + offset;
+					}
+					page++;
+					used = 0;
+				}
+			}
+		};
+
+		// the destructors of the messages that have one, no allocation per message
+		struct Destructor {
+			void (*destroy)(void* data);
+			void* data;
+		};
+
+		// the messages one thread posted in one frame
+		struct Queue : Arena {
+			std::vector<Message*> messages;
+			std::vector<Destructor> destructors;
+
+			void clear()
+			{
+				for (const auto& destructor : destructors)
+					destructor.destroy(destructor.data);
+				destructors.clear();
+				messages.clear();
+				page = 0;
+				used = 0;
+			}
+		};
+
+		struct Producer {
+			Queue queues[2]; // index = parity of the epoch
+			std::atomic<bool> busy = false;
+		};
+
+		template <typename T>
+		static auto messageId() -> std::uint32_t
+		{
+			static const std::uint32_t id = s_messageCount.fetch_add(1, std::memory_order_relaxed);
+			return id;
+		}
+
+		// the queues of the calling thread, registered the first time it posts on this bus
+		auto localProducer() -> Producer&
+		{
+			thread_local std::vector<std::pair<std::uint64_t, Producer*>> t_producers;
+			for (const auto& [bus, producer] : t_producers)
+				if (bus == busId)
+					return *producer;
+
+			std::scoped_lock lock(producersMutex);
+			auto* producer = producers.emplace_back(std::make_unique<Producer>()).get();
+			t_producers.emplace_back(busId, producer);
+			return *producer;
+		}
 
-		//auto findDelegate(std::type_index type) -> std::vector<std::function<void(const Message&)>>* {
-		//	if (auto it = std::find_if(callbacks.begin(), callbacks.end(), [&](const auto& val) { return type == val.first; });
-		//		it != callbacks.end())
-		//		return &it->second;
-		//	else
-		//		return nullptr;
-		//}
-
-		//std::vector<std::pair<std::type_index, std::vector<std::function<void(const Message&)>>>> callbacks;
-		std::vector<uint8_t> inBuffer;
-		std::vector<uint8_t> outBuffer;
-		uint8_t* inPointer;
-		uint8_t* outPointer;
-		int currentCount;
-		int pendingCount;
-		std::vector<std::function<void()>> inDestructors;
-		std::vector<std::function<void()>> outDestructors;
-		int inDtorCount;
-		int outDtorCount;
+		static inline std::atomic<std::uint32_t> s_messageCount = 0;
+		static inline std::atomic<std::uint64_t> s_busCount = 0;
+
+		// the thread local caches use it, a new bus at the same address is a different bus
+		const std::uint64_t busId = s_busCount.fetch_add(1, std::memory_order_relaxed) + 1;
+		std::atomic<std::uint64_t> epoch = 0; // the producers post in queues[epoch & 1]
+		std::mutex producersMutex;
+		std::vector<std::unique_ptr<Producer>> producers;
+
+		// consumer
+		std::vector<Producer*> consuming; // the producers when the frame started
+		std::size_t outQueue = 0;
+		std::size_t outProducer = 0;
+		std::size_t outIndex = 0;
+		std::vector<std::unique_ptr<Signal<void(const Message&)>>> handlers; // index = messageId<T>()
 	};
 }
@@ -3,6 +3,12 @@
 #include <functional>
 #include <vector>
 #include <typeindex>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <concepts>
 
 namespace ark
 {
@@ -12,21 +18,32 @@ namespace ark
 	template <typename>
 	class Sink;
 
+	template <typename>
+	class Delegate;
+
+	/* handle of a connected callback, release() disconnects it
+	 * it's a slot id + generation, so releasing twice or after the slot was reused does nothing
+	 * the signal must still exist when release() is called
+	*/
 	class Connection {
 		template <typename>
-		friend class Sink;
+		friend class Signal;
 
-		std::function<void()> m_func;
+		void* m_signal = nullptr;
+		void (*m_release)(void* signal, std::uint32_t slot, std::uint32_t generation) = nullptr;
+		std::uint32_t m_slot = 0;
+		std::uint32_t m_generation = 0;
 
-		Connection(std::function<void()>&& func) : m_func(std::move(func)) {}
+		Connection(void* signal, void (*release)(void*, std::uint32_t, std::uint32_t), std::uint32_t slot, std::uint32_t generation)
+			: m_signal(signal), m_release(release), m_slot(slot), m_generation(generation) {}
 	public:
 
 		Connection() = default;
 
 		void release() {
-			if (m_func) {
-				m_func();
-				m_func = nullptr;
+			if (m_release) {
+				m_release(m_signal, m_slot, m_generation);
+				m_release = nullptr;
 			}
 		}
 	};
@@ -39,14 +56,21 @@ namespace ark
 		ScopedConnection(const Connection& con) : m_con(con) {}
 		ScopedConnection(Connection&& con) : m_con(std::move(con)) {}
 
-		ScopedConnection(ScopedConnection&& con) noexcept : m_con(std::move(con.m_con)) {}
-		ScopedConnection& operator=(ScopedConnection&& con) noexcept { m_con = std::move(con.m_con); return *this; }
+		ScopedConnection(ScopedConnection&& con) noexcept : m_con(std::exchange(con.m_con, {})) {}
+		ScopedConnection& operator=(ScopedConnection&& con) noexcept {
+			if (this != &con) {
+				m_con.release();
+				m_con = std::exchange(con.m_con, {});
+			}
+			return *this;
+		}
 
 		ScopedConnection(const ScopedConnection&) = delete;
 		ScopedConnection& operator=(const ScopedConnection&) = delete;
 
 		ScopedConnection& operator=(Connection con) {
-			m_con = std::move(con);
+			m_con.release();
+			m_con = con;
 			return *this;
 		}
 
@@ -63,20 +87,187 @@ namespace ark
 		};
 	}
 
+	/* callable stored as a function pointer + payload, move-only
+	 * callables up to InlineSize bytes (lambdas with a few captures, function pointers, bind_front with a pointer)
+	 * live inside the delegate, bigger ones are allocated on the heap
+	 * Delegate::bind<&func>() stores nothing, the function is part of the call pointer
+	*/
+	template <typename Ret, typename... Args>
+	class Delegate<Ret(Args...)> {
+	public:
+		static constexpr std::size_t InlineSize = 3 * sizeof(void*);
+
+		Delegate() = default;
+
+		template <typename F>
+		requires (!std::same_as<std::remove_cvref_t<F>, Delegate>) && std::invocable<std::decay_t<F>&, Args...>
+		Delegate(F&& fun) {
+			using Fun = std::decay_t<F>;
+			if constexpr (isInline<Fun>()) {
+				std::construct_at(reinterpret_cast<Fun*>(m_buffer), std::forward<F>(fun));
+				if constexpr (!std::is_trivially_copyable_v<Fun>)
+					m_manage = [](void* to, void* from) {
+						if (to)
+							std::construct_at(static_cast<Fun*>(to), std::move(*static_cast<Fun*>(from)));
+						std::destroy_at(static_cast<Fun*>(from));
+					};
+			}
+			else {
+				m_heap = new Fun(std::forward<F>(fun));
+				m_manage = [](void* to, void* from) { delete static_cast<Fun*>(from); };
+			}
+			m_call = &call<Fun>;
+		}
+
+		template <auto Func>
+		requires std::invocable<decltype(Func), Args...>
+		static auto bind() -> Delegate {
+			Delegate delegate;
+			delegate.m_call = &callStatic<Func>;
+			return delegate;
+		}
+
+		Delegate(Delegate&& other) noexcept { steal(other); }
+
+		Delegate& operator=(Delegate&& other) noexcept {
+			if (this != &other) {
+				reset();
+				steal(other);
+			}
+			return *this;
+		}
+
+		Delegate(const Delegate&) = delete;
+		Delegate& operator=(const Delegate&) = delete;
+
+		~Delegate() { reset(); }
+
+		Ret operator()(Args... args) const {
+			return m_call(payload(), std::forward<Args>(args)...);
+		}
+
+		explicit operator bool() const noexcept { return m_call != nullptr; }
+
+		// true if made by bind<Func>()
+		template <auto Func>
+		bool isBound() const noexcept { return m_call == &callStatic<Func>; }
+
+		void reset() noexcept {
+			if (m_manage)
+				m_manage(nullptr, payload());
+			m_call = nullptr;
+			m_manage = nullptr;
+			m_heap = nullptr;
+		}
+
+	private:
+		// to == nullptr: only destroy 'from'
+		using Manage = void (*)(void* to, void* from);
+		using Call = Ret (*)(void* payload, Args... args);
+
+		template <typename Fun>
+		static constexpr bool isInline() {
+			return sizeof(Fun) <= InlineSize && alignof(Fun) <= alignof(void*) && std::is_nothrow_move_constructible_v<Fun>;
+		}
+
+		template <typename Fun>
+		static Ret call(void* payload, Args... args) {
+			if constexpr (std::is_void_v<Ret>)
+				std::invoke(*static_cast<Fun*>(payload), std::forward<Args>(args)...);
+			else
+				return std::invoke(*static_cast<Fun*>(payload), std::forward<Args>(args)...);
+		}
+
+		template <auto Func>
+		static Ret callStatic(void*, Args... args) {
+			if constexpr (std::is_void_v<Ret>)
+				std::invoke(Func, std::forward<Args>(args)...);
+			else
+				return std::invoke(Func, std::forward<Args>(args)...);
+		}
+
+		void* payload() const noexcept {
+			return m_heap ? m_heap : const_cast<std::byte*>(m_buffer);
+		}
+
+		void steal(Delegate& other) noexcept {
+			m_call = std::exchange(other.m_call, nullptr);
+			m_manage = std::exchange(other.m_manage, nullptr);
+			m_heap = std::exchange(other.m_heap, nullptr);
+			if (m_heap)
+				return;
+			if (m_manage)
+				m_manage(m_buffer, other.m_buffer);
+			else
+				std::memcpy(m_buffer, other.m_buffer, InlineSize);
+		}
+
+		Call m_call = nullptr;
+		Manage m_manage = nullptr; // nullptr for trivially copyable inline callables
+		void* m_heap = nullptr;
+		alignas(void*) std::byte m_buffer[InlineSize];
+	};
+
+	/* callbacks are called in connection order
+	 * the connections are kept in a slot map: Connection is an index + generation, no allocation per connect
+	 * don't connect/disconnect a signal from inside one of its own callbacks
+	*/
 	template <typename Ret, typename ...Args>
 	class Signal<Ret(Args...)> {
 		friend class Sink<Ret(Args...)>;
 
-		std::vector<std::function<Ret(Args...)>> m_funcs;
+		static constexpr std::uint32_t NoSlot = ~std::uint32_t(0);
+
+		struct Slot {
+			std::uint32_t index; // in m_delegates, or the next free slot
+			std::uint32_t generation = 0;
+		};
+
+		std::vector<Delegate<Ret(Args...)>> m_delegates;
+		std::vector<std::uint32_t> m_slotOf; // index in m_delegates -> slot
+		std::vector<Slot> m_slots;
+		std::uint32_t m_freeSlot = NoSlot;
 
 	public:
 		using sink_type = Sink<Ret(Args...)>;
 
-		int size() const { return m_funcs.size(); }
+		int size() const { return static_cast<int>(m_delegates.size()); }
 
 		void publish(Args... args) const {
-			for (auto&& fun : std::as_const(m_funcs))
-				fun(args...);
+			for (auto& delegate : m_delegates)
+				delegate(args...);
+		}
+
+	private:
+		Connection add(Delegate<Ret(Args...)>&& delegate) {
+			std::uint32_t slot = m_freeSlot;
+			if (slot != NoSlot)
+				m_freeSlot = m_slots[slot].index;
+			else {
+				slot = static_cast<std::uint32_t>(m_slots.size());
+				m_slots.emplace_back();
+			}
+			m_slots[slot].index = static_cast<std::uint32_t>(m_delegates.size());
+			m_delegates.push_back(std::move(delegate));
+			m_slotOf.push_back(slot);
+			return Connection(this, &Signal::release, slot, m_slots[slot].generation);
+		}
+
+		void remove(std::uint32_t slot, std::uint32_t generation) {
+			if (slot >= m_slots.size() || m_slots[slot].generation != generation)
+				return;
+			const auto index = m_slots[slot].index;
+			m_delegates.erase(m_delegates.begin() + index);
+			m_slotOf.erase(m_slotOf.begin() + index);
+			for (auto i = index; i < m_slotOf.size(); i++)
+				m_slots[m_slotOf[i]].index = i;
+			m_slots[slot].generation++;
+			m_slots[slot].index = m_freeSlot;
+			m_freeSlot = slot;
+		}
+
+		static void release(void* signal, std::uint32_t slot, std::uint32_t generation) {
+			static_cast<Signal*>(signal)->remove(slot, generation);
 		}
 	};
 
@@ -86,41 +277,29 @@ namespace ark
 
 	public:
 		using signal_type = Signal<Ret(Args...)>;
-	private:
-
-		static void disconnect(signal_type* signal, std::type_index info) {
-			std::erase_if(signal->m_funcs,
-				[&](const auto& fun) { return fun.target_type() == info; });
-		}
-
-	public:
 
 		Sink(signal_type& signal) noexcept : m_signal(&signal) {}
 
 		template <auto Func>
 		Connection connect() {
-			return connect(Func);
+			return m_signal->add(Delegate<Ret(Args...)>::template bind<Func>());
 		}
 
 		template <typename F, typename... Payload>
 		requires std::invocable<F, Payload..., Args...>
 			Connection connect(F&& fn, Payload&&... pay) {
-			std::type_index type = typeid(void);
-			if constexpr (sizeof...(Payload) == 0) {
-				type = m_signal->m_funcs.emplace_back(std::forward<F>(fn)).target_type();
-			}
-			else {
-				auto fun = ark::bind_front(fn, std::forward<Payload>(pay)...);
-				type = m_signal->m_funcs.emplace_back(std::move(fun)).target_type();
-			}
-			return Connection([type, sig = this->m_signal]{
-				Sink::disconnect(sig, type);
-				});
+			if constexpr (sizeof...(Payload) == 0)
+				return m_signal->add(Delegate<Ret(Args...)>(std::forward<F>(fn)));
+			else
+				return m_signal->add(Delegate<Ret(Args...)>(ark::bind_front(std::forward<F>(fn), std::forward<Payload>(pay)...)));
 		}
 
+		// disconnects the callbacks connected with connect<Func>()
 		template <auto Func>
 		void disconnect() {
-			disconnect(m_signal, typeid(Func));
+			for (std::size_t i = m_signal->m_delegates.size(); i-- > 0;)
+				if (m_signal->m_delegates[i].template isBound<Func>())
+					m_signal->remove(m_signal->m_slotOf[i], m_signal->m_slots[m_signal->m_slotOf[i]].generation);
 		}
 	};
 
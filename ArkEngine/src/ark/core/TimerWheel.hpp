@@ -0,0 +1,306 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <utility>
+#include <limits>
+#include <cstdint>
+#include <concepts>
+
+#include <SFML/System/Time.hpp>
+
+#include "ark/core/Core.hpp"
+#include "ark/core/Signal.hpp"
+#include "ark/util/Util.hpp"
+
+namespace ark {
+
+	/* handle of a scheduled timer, index + generation like Connection
+	 * stays safe to use after the timer fired or was cancelled, cancel() on it does nothing
+	*/
+	struct TimerHandle {
+		std::uint32_t index = std::numeric_limits<std::uint32_t>::max();
+		std::uint32_t generation = 0;
+
+		explicit operator bool() const { return index != std::numeric_limits<std::uint32_t>::max(); }
+	};
+
+	/* Timer wheel ierarhic
+	 *
+	 * Timpul e impartit in tick-uri de 'resolution' (1ms implicit). Nivelul 0 are 256 de sloturi, cate unul pentru
+	 * fiecare tick, nivelele 1-3 cate 64 de sloturi, fiecare acoperind cate un slot intreg de pe nivelul de dedesubt
+	 * (256ms, ~16s, ~17min; ce e mai departe de ~18h asteapta in ultimul nivel si e reprogramat cand ajunge acolo).
+	 * Cand nivelul 0 face o tura, slotul curent de pe nivelul 1 e mutat pe nivelul 0 (cascade), etc.
+	 *
+	 * schedule() si cancel() sunt O(1), advance() atinge doar tick-urile scurse, timer-ele care expira in ele
+	 * si, o data la 256 de tick-uri, cele mutate de pe nivelul de deasupra. Un wheel gol nu parcurge tick-urile.
+	 *
+	 * Un timer poate fi legat de un grup (de exemplu id-ul unei entitati), cancelGroup() le anuleaza pe toate.
+	 * Callback-urile sunt apelate din advance() si pot programa/anula alte timere, dar nu pot apela advance().
+	 * Timer-ele care expira in acelasi tick sunt apelate in ordine nespecificata.
+	*/
+	class TimerWheel final : public NonCopyable {
+	public:
+		using Callback = Delegate<void()>;
+		static constexpr std::uint32_t NoGroup = std::numeric_limits<std::uint32_t>::max();
+
+		explicit TimerWheel(sf::Time resolution = sf::milliseconds(1))
+			: m_resolution(std::max<std::int64_t>(1, resolution.asMicroseconds()))
+		{
+			m_slots.fill(Nil);
+		}
+
+		// fun() is called from the first advance() that reaches 'delay', a delay of zero fires on the next tick
+		template <typename F>
+		requires std::invocable<std::decay_t<F>&>
+		auto schedule(sf::Time delay, F&& fun, std::uint32_t group = NoGroup) -> TimerHandle
+		{
+			const auto index = allocate();
+			auto& node = m_nodes[index];
+			node.callback = Callback(std::forward<F>(fun));
+			node.expires = m_now + ticksFrom(delay);
+			node.group = group;
+			insert(index, m_now + 1);
+			if (group != NoGroup)
+				linkGroup(index);
+			m_count++;
+			return { index, node.generation };
+		}
+
+		// false if the timer already fired or was cancelled
+		bool cancel(TimerHandle handle)
+		{
+			if (!isPending(handle))
+				return false;
+			release(handle.index);
+			return true;
+		}
+
+		bool isPending(TimerHandle handle) const
+		{
+			return handle.index < m_nodes.size() && m_nodes[handle.index].generation == handle.generation
+				&& m_nodes[handle.index].slot != Nil;
+		}
+
+		// the time left until the timer fires, zero if it isn't pending
+		auto remaining(TimerHandle handle) const -> sf::Time
+		{
+			if (!isPending(handle))
+				return sf::Time::Zero;
+			const auto ticks = static_cast<std::int64_t>(m_nodes[handle.index].expires - m_now);
+			return sf::microseconds(std::max<std::int64_t>(0, ticks * m_resolution - m_elapsed));
+		}
+
+		// cancels every timer of the group, O(timers in the group)
+		void cancelGroup(std::uint32_t group)
+		{
+			if (group >= m_groups.size())
+				return;
+			while (m_groups[group] != Nil)
+				release(m_groups[group]);
+		}
+
+		void advance(sf::Time dt)
+		{
+			m_elapsed += dt.asMicroseconds();
+			if (m_elapsed < m_resolution)
+				return;
+			auto ticks = static_cast<std::uint64_t>(m_elapsed / m_resolution);
+			m_elapsed %= m_resolution;
+
+			while (ticks--) {
+				if (m_count == 0) {
+					// nothing to cascade or fire, the empty slots don't need to be visited
+					m_now += ticks + 1;
+					break;
+				}
+				tick();
+			}
+		}
+
+		// the number of pending timers
+		auto size() const -> std::size_t { return m_count; }
+
+		void clear()
+		{
+			for (std::uint32_t i = 0; i < m_nodes.size(); i++)
+				if (m_nodes[i].slot != Nil)
+					release(i);
+		}
+
+	private:
+		static constexpr std::uint32_t Nil = std::numeric_limits<std::uint32_t>::max();
+		static constexpr std::uint32_t RootBits = 8;
+		static constexpr std::uint32_t LevelBits = 6;
+		static constexpr std::uint32_t RootSize = 1 << RootBits;
+		static constexpr std::uint32_t LevelSize = 1 << LevelBits;
+		static constexpr std::uint32_t Levels = 3; // above the root
+		static constexpr std::uint64_t MaxDelta = (std::uint64_t{ 1 } << (RootBits + Levels * LevelBits)) - 1;
+		// the timers taken out of the current root slot while their callbacks run
+		static constexpr std::uint32_t FiringSlot = RootSize + Levels * LevelSize;
+
+		struct Node {
+			Callback callback;
+			std::uint64_t expires = 0; // tick
+			std::uint32_t generation = 0;
+			std::uint32_t slot = Nil; // Nil when the node is free
+			std::uint32_t prev = Nil;
+			std::uint32_t next = Nil; // also the free list
+			std::uint32_t group = NoGroup;
+			std::uint32_t groupPrev = Nil;
+			std::uint32_t groupNext = Nil;
+		};
+
+		auto ticksFrom(sf::Time delay) const -> std::uint64_t
+		{
+			// rounded up, so a timer never fires early, and at least the next tick
+			const auto us = std::max<std::int64_t>(0, delay.asMicroseconds());
+			return std::max<std::uint64_t>(1, static_cast<std::uint64_t>((us + m_resolution - 1) / m_resolution));
+		}
+
+		auto allocate() -> std::uint32_t
+		{
+			if (m_free == Nil) {
+				m_nodes.emplace_back();
+				return static_cast<std::uint32_t>(m_nodes.size() - 1);
+			}
+			const auto index = m_free;
+			m_free = m_nodes[index].next;
+			return index;
+		}
+
+		// unlinks the node and puts it on the free list, the old handles stop matching
+		void release(std::uint32_t index)
+		{
+			auto& node = m_nodes[index];
+			unlink(index);
+			if (node.group != NoGroup)
+				unlinkGroup(index);
+			node.callback = {};
+			node.slot = Nil;
+			node.generation++;
+			node.next = m_free;
+			m_free = index;
+			m_count--;
+		}
+
+		// the slot is picked from the distance to 'base', the first tick that will still visit its root slot
+		void insert(std::uint32_t index, std::uint64_t base)
+		{
+			auto& node = m_nodes[index];
+			const auto expires = std::max(node.expires, base);
+			const auto delta = std::min<std::uint64_t>(expires - base, MaxDelta);
+			const auto at = base + delta;
+
+			std::uint32_t slot;
+			if (delta < RootSize)
+				slot = static_cast<std::uint32_t>(at & (RootSize - 1));
+			else {
+				std::uint32_t level = 0;
+				while (delta >= (std::uint64_t{ 1 } << (RootBits + (level + 1) * LevelBits)))
+					level++;
+				const auto shift = RootBits + level * LevelBits;
+				slot = RootSize + level * LevelSize + static_cast<std::uint32_t>((at >> shift) & (LevelSize - 1));
+			}
+			link(index, slot);
+		}
+
+		void link(std::uint32_t index, std::uint32_t slot)
+		{
+			auto& node = m_nodes[index];
+			node.slot = slot;
+			node.prev = Nil;
+			node.next = m_slots[slot];
+			if (node.next != Nil)
+				m_nodes[node.next].prev = index;
+			m_slots[slot] = index;
+		}
+
+		void unlink(std::uint32_t index)
+		{
+			auto& node = m_nodes[index];
+			if (node.prev != Nil)
+				m_nodes[node.prev].next = node.next;
+			else
+				m_slots[node.slot] = node.next;
+			if (node.next != Nil)
+				m_nodes[node.next].prev = node.prev;
+		}
+
+		void linkGroup(std::uint32_t index)
+		{
+			auto& node = m_nodes[index];
+			if (node.group >= m_groups.size())
+				m_groups.resize(node.group + 1, Nil);
+			node.groupPrev = Nil;
+			node.groupNext = m_groups[node.group];
+			if (node.groupNext != Nil)
+				m_nodes[node.groupNext].groupPrev = index;
+			m_groups[node.group] = index;
+		}
+
+		void unlinkGroup(std::uint32_t index)
+		{
+			auto& node = m_nodes[index];
+			if (node.groupPrev != Nil)
+				m_nodes[node.groupPrev].groupNext = node.groupNext;
+			else
+				m_groups[node.group] = node.groupNext;
+			if (node.groupNext != Nil)
+				m_nodes[node.groupNext].groupPrev = node.groupPrev;
+		}
+
+		// moves the timers of a slot one level down (or to the root), the root slot of 'now' wasn't fired yet
+		void cascade(std::uint32_t slot, std::uint64_t now)
+		{
+			auto index = std::exchange(m_slots[slot], Nil);
+			while (index != Nil) {
+				const auto next = m_nodes[index].next;
+				insert(index, now);
+				index = next;
+			}
+		}
+
+		void tick()
+		{
+			const auto now = ++m_now;
+			const auto root = static_cast<std::uint32_t>(now & (RootSize - 1));
+			// every time a level wraps, the next slot of the level above is spread on it
+			for (std::uint32_t level = 0; level < Levels; level++) {
+				const auto shift = RootBits + level * LevelBits;
+				if ((now & ((std::uint64_t{ 1 } << shift) - 1)) != 0)
+					break;
+				cascade(RootSize + level * LevelSize + static_cast<std::uint32_t>((now >> shift) & (LevelSize - 1)), now);
+			}
+
+			// the callbacks can schedule in this same root slot (delay of RootSize ticks), so the expired ones are taken out first
+			m_slots[FiringSlot] = std::exchange(m_slots[root], Nil);
+			for (auto index = m_slots[FiringSlot]; index != Nil; index = m_nodes[index].next)
+				m_nodes[index].slot = FiringSlot;
+
+			while (m_slots[FiringSlot] != Nil) {
+				const auto index = m_slots[FiringSlot];
+				if (m_nodes[index].expires > now) {
+					// not expected, the cascades place every timer in the root slot of its tick
+					unlink(index);
+					insert(index, now + 1);
+					continue;
+				}
+				auto callback = std::move(m_nodes[index].callback);
+				release(index);
+				// may cancel the other timers of this tick, they are unlinked from the firing slot
+				callback();
+			}
+		}
+
+		std::vector<Node> m_nodes;
+		std::array<std::uint32_t, FiringSlot + 1> m_slots;
+		std::vector<std::uint32_t> m_groups; // index = group, the first timer of the group
+		std::uint32_t m_free = Nil;
+		std::size_t m_count = 0;
+		std::uint64_t m_now = 0; // the last processed tick
+		std::int64_t m_elapsed = 0; // microseconds since the last tick
+		const std::int64_t m_resolution; // microseconds per tick
+	};
+}
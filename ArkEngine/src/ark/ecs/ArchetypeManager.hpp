@@ -0,0 +1,373 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <span>
+#include <memory_resource>
+
+#include "ark/ecs/Component.hpp"
+#include "ark/ecs/Entity.hpp"
+
+/* Storage alternativ pentru EntityManager (StoragePolicy::Archetype)
+ *
+ * Entitatile cu aceeasi masca de componente formeaza un archetype. Un archetype isi tine
+ * componentele in chunk-uri de marime fixa (default 16 KiB), SoA:
+ *
+ *   chunk: [ EntityId x capacity ][ C0 x capacity ][ C1 x capacity ] ... [ ticks C0 x capacity ][ ticks C1 x capacity ] ...
+ *
+ * Randurile sunt impachetate: toate chunk-urile sunt pline in afara de ultimul, iar la scoatere
+ * ultimul rand din archetype e mutat in locul celui scos (swap-remove).
+ * Add/remove de componenta muta entitatea in archetype-ul vecin (muchiile sunt tinute in cache).
+ *
+ * ATENTIE: spre deosebire de pool-urile sparse, pointerii/referintele catre componente sunt invalidati
+ * de orice add/remove/destroy (al oricarei entitati din acelasi archetype).
+ * Pastreaza un ark::Entity si fa get() din nou in loc sa tii pointeri.
+*/
+
+namespace ark {
+
+	class ArchetypeManager final : public NonCopyable {
+	public:
+		static constexpr std::size_t DefaultChunkSize = 16 * 1024;
+		static constexpr std::size_t ChunkAlign = 64;
+
+		struct Chunk {
+			std::byte* data = nullptr;
+		};
+
+		struct Archetype {
+			ComponentMask mask;
+			std::vector<int> compIds; // column -> component id
+			std::vector<const meta::Metadata*> metadata; // column -> metadata
+			std::vector<std::size_t> offsets; // column -> byte offset inside chunk
+			std::vector<std::size_t> tickOffsets; // column -> byte offset of its ComponentTicks inside chunk
+			std::array<int, MaxComponentTypes> columnOf; // component id -> column, ArkInvalidIndex if missing
+			std::array<int, MaxComponentTypes> edgeAdd; // component id -> archetype index, ArkInvalidIndex if not yet computed
+			std::array<int, MaxComponentTypes> edgeRemove;
+			std::size_t capacity = 0; // rows per chunk
+			std::size_t chunkBytes = 0;
+			std::vector<Chunk> chunks;
+			int size = 0; // number of entities
+
+			auto entities(std::size_t chunk) const noexcept -> Entity::ID* {
+				return reinterpret_cast<Entity::ID*>(chunks[chunk].data);
+			}
+
+			auto column(std::size_t chunk, int col) const noexcept -> std::byte* {
+				return chunks[chunk].data + offsets[col];
+			}
+
+			auto component(std::size_t chunk, std::size_t row, int col) const noexcept -> void* {
+				return column(chunk, col) + row * metadata[col]->size;
+			}
+
+			auto ticks(std::size_t chunk, int col) const noexcept -> ComponentTicks* {
+				return reinterpret_cast<ComponentTicks*>(chunks[chunk].data + tickOffsets[col]);
+			}
+
+			// number of used rows in 'chunk'
+			auto rows(std::size_t chunk) const noexcept -> std::size_t {
+				return std::min(capacity, size - chunk * capacity);
+			}
+
+			auto usedChunks() const noexcept -> std::size_t {
+				return (size + capacity - 1) / capacity;
+			}
+		};
+
+		struct Location {
+			int archetype = ArkInvalidIndex;
+			int chunk = 0;
+			int row = 0;
+		};
+
+		ArchetypeManager(std::size_t chunkSize, std::pmr::memory_resource* resource)
+			: m_chunkSize(chunkSize), m_resource(resource) { }
+
+		~ArchetypeManager()
+		{
+			for (auto& arch : m_archetypes) {
+				for (std::size_t chunk = 0; chunk < arch.usedChunks(); chunk++)
+					for (std::size_t row = 0; row < arch.rows(chunk); row++)
+						for (int col = 0; col < arch.compIds.size(); col++)
+							if (arch.metadata[col]->destructor)
+								arch.metadata[col]->destructor(arch.component(chunk, row, col));
+				for (auto chunk : arch.chunks)
+					m_resource->deallocate(chunk.data, arch.chunkBytes, ChunkAlign);
+			}
+		}
+
+		/* moves the entity in the archetype with 'compId' added
+		 * returns uninitialized memory for the new component, the caller must construct it
+		*/
+		void* emplace(Entity::ID entity, int compId, const meta::Metadata& metadata, ChangeTick tick)
+		{
+			if (entity >= m_locations.size())
+				m_locations.resize(entity + 1);
+			m_metadata[compId] = &metadata;
+			auto src = m_locations[entity];
+
+			int dstIndex;
+			if (src.archetype == ArkInvalidIndex)
+				dstIndex = findOrCreate(ComponentMask{}.set(compId));
+			else {
+				dstIndex = m_archetypes[src.archetype].edgeAdd[compId];
+				if (dstIndex == ArkInvalidIndex) {
+					dstIndex = findOrCreate(ComponentMask{ m_archetypes[src.archetype].mask }.set(compId));
+					m_archetypes[src.archetype].edgeAdd[compId] = dstIndex;
+					m_archetypes[dstIndex].edgeRemove[compId] = src.archetype;
+				}
+			}
+
+			auto dst = moveEntity(entity, src, dstIndex, ArkInvalidIndex);
+			auto& arch = m_archetypes[dstIndex];
+			int col = arch.columnOf[compId];
+			arch.ticks(dst.chunk, col)[dst.row] = { tick, tick };
+			return arch.component(dst.chunk, dst.row, col);
+		}
+
+		// destroys the component and moves the entity in the archetype without 'compId'
+		void erase(Entity::ID entity, int compId)
+		{
+			auto src = m_locations[entity];
+			auto& srcArch = m_archetypes[src.archetype];
+			int col = srcArch.columnOf[compId];
+			if (srcArch.metadata[col]->destructor)
+				srcArch.metadata[col]->destructor(srcArch.component(src.chunk, src.row, col));
+
+			if (srcArch.compIds.size() == 1) {
+				removeRow(src);
+				m_locations[entity] = {};
+				return;
+			}
+
+			int dstIndex = srcArch.edgeRemove[compId];
+			if (dstIndex == ArkInvalidIndex) {
+				dstIndex = findOrCreate(ComponentMask{ srcArch.mask }.reset(compId));
+				m_archetypes[src.archetype].edgeRemove[compId] = dstIndex;
+				m_archetypes[dstIndex].edgeAdd[compId] = src.archetype;
+			}
+			moveEntity(entity, src, dstIndex, col);
+		}
+
+		/* bulk creation: places an entity without components directly in the archetype of 'mask'
+		 * every component of 'mask' must have its metadata set and is left uninitialized
+		*/
+		auto insert(Entity::ID entity, ComponentMask mask, ChangeTick tick) -> Location
+		{
+			if (entity >= m_locations.size())
+				m_locations.resize(entity + 1);
+			auto loc = m_locations[entity] = pushRow(entity, findOrCreate(mask));
+			auto& arch = m_archetypes[loc.archetype];
+			for (int col = 0; col < arch.compIds.size(); col++)
+				arch.ticks(loc.chunk, col)[loc.row] = { tick, tick };
+			return loc;
+		}
+
+		// allocates the chunks for 'count' more entities in the archetype of 'mask'
+		void reserve(ComponentMask mask, std::size_t count)
+		{
+			auto& arch = m_archetypes[findOrCreate(mask)];
+			auto chunks = (arch.size + count + arch.capacity - 1) / arch.capacity;
+			while (arch.chunks.size() < chunks)
+				arch.chunks.push_back({ static_cast<std::byte*>(m_resource->allocate(arch.chunkBytes, ChunkAlign)) });
+		}
+
+		void setMetadata(int compId, const meta::Metadata& metadata) { m_metadata[compId] = &metadata; }
+
+		// releases the spare chunks, the rows are always packed so nothing is moved
+		void shrink()
+		{
+			for (auto& arch : m_archetypes) {
+				while (arch.chunks.size() > arch.usedChunks()) {
+					m_resource->deallocate(arch.chunks.back().data, arch.chunkBytes, ChunkAlign);
+					arch.chunks.pop_back();
+				}
+			}
+		}
+
+		// destroys every component of the entity and its row
+		void destroy(Entity::ID entity)
+		{
+			if (entity >= m_locations.size() || m_locations[entity].archetype == ArkInvalidIndex)
+				return;
+			auto loc = m_locations[entity];
+			auto& arch = m_archetypes[loc.archetype];
+			for (int col = 0; col < arch.compIds.size(); col++)
+				if (arch.metadata[col]->destructor)
+					arch.metadata[col]->destructor(arch.component(loc.chunk, loc.row, col));
+			removeRow(loc);
+			m_locations[entity] = {};
+		}
+
+		void* tryGet(Entity::ID entity, int compId) const noexcept
+		{
+			if (entity < 0 || entity >= m_locations.size())
+				return nullptr;
+			auto loc = m_locations[entity];
+			if (loc.archetype == ArkInvalidIndex)
+				return nullptr;
+			auto& arch = m_archetypes[loc.archetype];
+			int col = arch.columnOf[compId];
+			return col == ArkInvalidIndex ? nullptr : arch.component(loc.chunk, loc.row, col);
+		}
+
+		// also marks the component as changed at 'tick'
+		void* tryGet(Entity::ID entity, int compId, ChangeTick tick) noexcept
+		{
+			if (entity < 0 || entity >= m_locations.size())
+				return nullptr;
+			auto loc = m_locations[entity];
+			if (loc.archetype == ArkInvalidIndex)
+				return nullptr;
+			auto& arch = m_archetypes[loc.archetype];
+			int col = arch.columnOf[compId];
+			if (col == ArkInvalidIndex)
+				return nullptr;
+			arch.ticks(loc.chunk, col)[loc.row].changed = tick;
+			return arch.component(loc.chunk, loc.row, col);
+		}
+
+		void* get(Entity::ID entity, int compId) const noexcept
+		{
+			auto loc = m_locations[entity];
+			auto& arch = m_archetypes[loc.archetype];
+			return arch.component(loc.chunk, loc.row, arch.columnOf[compId]);
+		}
+
+		// the entity must have the component
+		auto ticks(Entity::ID entity, int compId) const noexcept -> ComponentTicks&
+		{
+			auto loc = m_locations[entity];
+			auto& arch = m_archetypes[loc.archetype];
+			return arch.ticks(loc.chunk, arch.columnOf[compId])[loc.row];
+		}
+
+		// archetype indices are stable, new archetypes are appended
+		auto archetypes() const noexcept -> std::span<const Archetype> { return m_archetypes; }
+
+		auto chunkSize() const noexcept -> std::size_t { return m_chunkSize; }
+
+	private:
+
+		int findOrCreate(ComponentMask mask)
+		{
+			for (int i = 0; i < m_archetypes.size(); i++)
+				if (m_archetypes[i].mask == mask)
+					return i;
+
+			auto& arch = m_archetypes.emplace_back();
+			arch.mask = mask;
+			arch.columnOf.fill(ArkInvalidIndex);
+			arch.edgeAdd.fill(ArkInvalidIndex);
+			arch.edgeRemove.fill(ArkInvalidIndex);
+
+			for (int compId = 0; compId < MaxComponentTypes; compId++) {
+				if (!mask.test(compId))
+					continue;
+				arch.columnOf[compId] = static_cast<int>(arch.compIds.size());
+				arch.compIds.push_back(compId);
+				arch.metadata.push_back(m_metadata[compId]);
+			}
+
+			// cate randuri intra intr-un chunk, padding-ul de aliniere e cel mult suma alinierilor
+			std::size_t rowBytes = sizeof(Entity::ID);
+			std::size_t padding = 0;
+			for (auto* metadata : arch.metadata) {
+				rowBytes += metadata->size + sizeof(ComponentTicks);
+				padding += metadata->align + alignof(ComponentTicks);
+			}
+			arch.capacity = m_chunkSize > padding ? std::max<std::size_t>(1, (m_chunkSize - padding) / rowBytes) : 1;
+
+			std::size_t offset = arch.capacity * sizeof(Entity::ID);
+			for (auto* metadata : arch.metadata) {
+				offset = (offset + metadata->align - 1) / metadata->align * metadata->align;
+				arch.offsets.push_back(offset);
+				offset += arch.capacity * metadata->size;
+			}
+			for (std::size_t col = 0; col < arch.metadata.size(); col++) {
+				offset = (offset + alignof(ComponentTicks) - 1) / alignof(ComponentTicks) * alignof(ComponentTicks);
+				arch.tickOffsets.push_back(offset);
+				offset += arch.capacity * sizeof(ComponentTicks);
+			}
+			arch.chunkBytes = std::max(offset, m_chunkSize);
+
+			return static_cast<int>(m_archetypes.size() - 1);
+		}
+
+		// appends a row for 'entity' in archetype 'archIndex', components are left uninitialized
+		auto pushRow(Entity::ID entity, int archIndex) -> Location
+		{
+			auto& arch = m_archetypes[archIndex];
+			std::size_t chunk = arch.size / arch.capacity;
+			std::size_t row = arch.size % arch.capacity;
+			if (chunk == arch.chunks.size())
+				arch.chunks.push_back({ static_cast<std::byte*>(m_resource->allocate(arch.chunkBytes, ChunkAlign)) });
+			arch.entities(chunk)[row] = entity;
+			arch.size++;
+			return { archIndex, static_cast<int>(chunk), static_cast<int>(row) };
+		}
+
+		/* fills the hole at 'loc' with the last row of the archetype
+		 * the components in the hole must already be destroyed or moved from
+		*/
+		void removeRow(Location loc)
+		{
+			auto& arch = m_archetypes[loc.archetype];
+			int lastIndex = arch.size - 1;
+			std::size_t lastChunk = lastIndex / arch.capacity;
+			std::size_t lastRow = lastIndex % arch.capacity;
+
+			if (lastChunk != loc.chunk || lastRow != loc.row) {
+				for (int col = 0; col < arch.compIds.size(); col++) {
+					void* from = arch.component(lastChunk, lastRow, col);
+					arch.metadata[col]->move_constructor(arch.component(loc.chunk, loc.row, col), from);
+					if (arch.metadata[col]->destructor)
+						arch.metadata[col]->destructor(from);
+					arch.ticks(loc.chunk, col)[loc.row] = arch.ticks(lastChunk, col)[lastRow];
+				}
+				Entity::ID moved = arch.entities(lastChunk)[lastRow];
+				arch.entities(loc.chunk)[loc.row] = moved;
+				m_locations[moved] = loc;
+			}
+			arch.size--;
+
+			// pastram un chunk liber de rezerva ca sa nu alocam/dealocam in bucla la granita
+			while (arch.chunks.size() > arch.usedChunks() + 1) {
+				m_resource->deallocate(arch.chunks.back().data, arch.chunkBytes, ChunkAlign);
+				arch.chunks.pop_back();
+			}
+		}
+
+		// moves all components shared by 'src' and 'dstIndex', column 'destroyedCol' of src was already destroyed
+		auto moveEntity(Entity::ID entity, Location src, int dstIndex, int destroyedCol) -> Location
+		{
+			auto dst = pushRow(entity, dstIndex);
+			if (src.archetype != ArkInvalidIndex) {
+				auto& srcArch = m_archetypes[src.archetype];
+				auto& dstArch = m_archetypes[dstIndex];
+				for (int col = 0; col < srcArch.compIds.size(); col++) {
+					if (col == destroyedCol)
+						continue;
+					auto* metadata = srcArch.metadata[col];
+					int dstCol = dstArch.columnOf[srcArch.compIds[col]];
+					void* from = srcArch.component(src.chunk, src.row, col);
+					metadata->move_constructor(dstArch.component(dst.chunk, dst.row, dstCol), from);
+					if (metadata->destructor)
+						metadata->destructor(from);
+					dstArch.ticks(dst.chunk, dstCol)[dst.row] = srcArch.ticks(src.chunk, col)[src.row];
+				}
+				removeRow(src);
+			}
+			m_locations[entity] = dst;
+			return dst;
+		}
+
+	private:
+		std::size_t m_chunkSize;
+		std::pmr::memory_resource* m_resource;
+		std::vector<Archetype> m_archetypes;
+		std::vector<Location> m_locations; // index = entity id
+		std::array<const meta::Metadata*, MaxComponentTypes> m_metadata{}; // index = component id
+	};
+}
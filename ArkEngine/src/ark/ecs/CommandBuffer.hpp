@@ -0,0 +1,376 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+
+#include "ark/ecs/EntityManager.hpp"
+#include "ark/core/JobSystem.hpp"
+
+namespace ark {
+
+	/* Inregistreaza schimbari de structura (create/destroy/clone, add/remove de componente) ca sa fie aplicate mai tarziu
+	 *
+	 * Se foloseste cand structura nu poate fi schimbata pe loc: in timpul unui each()/par_each() sau din sistemele
+	 * care ruleaza in paralel. Schimbarile se aplica toate odata la playback() (un sync point), SystemManager face
+	 * playback la buffer-ul lui dupa fiecare update.
+	 *
+	 * Inregistrarea e thread-safe: thread-ul care a creat buffer-ul (main thread) si job-urile din JobSystem::global()
+	 * au fiecare stream-ul lui, fara lock-uri; celelalte thread-uri impart un stream in plus, protejat de un mutex.
+	 * playback()/discard() nu pot rula in acelasi timp cu inregistrarea.
+	 *
+	 * createEntity()/clone() returneaza un id temporar (negativ) care poate fi folosit doar cu acelasi buffer.
+	 *
+	 * La playback:
+	 *   1. create, toate cu un singur createEntities, apoi clone, in ordinea inregistrarii; clone copiaza entitatea
+	 *      asa cum e inainte de restul comenzilor
+	 *   2. add/remove, sortate dupa tipul componentei si entitate, ca un pool sa fie atins o singura data;
+	 *      pentru fiecare tip: intai remove-urile, apoi add-urile odata (storage rezervat o data, onAddBatch o data)
+	 *      comenzile pentru aceeasi componenta a aceleiasi entitati se reduc la efectul lor final
+	 *      (add + remove nu face nimic, remove + add inlocuieste componenta, add peste o componenta existenta e ignorat ca la EntityManager::add)
+	 *   3. destroy, comenzile de mai sus pentru entitatile distruse sunt ignorate
+	 * Semnalele sunt publicate in ordinea de mai sus, nu in ordinea inregistrarii.
+	*/
+	class CommandBuffer final : public NonCopyable {
+	public:
+		explicit CommandBuffer(EntityManager& manager)
+			: m_manager(&manager), m_owner(std::this_thread::get_id())
+		{
+			// the workers, the owner thread and the threads outside of the pool
+			auto streamCount = JobSystem::global().workerCount() + 2;
+			for (unsigned i = 0; i < streamCount; i++)
+				m_streams.push_back(std::make_unique<Stream>());
+		}
+
+		~CommandBuffer()
+		{
+			discard();
+		}
+
+		// returns a temporary id, only valid for commands of this buffer
+		auto createEntity() -> EntityId
+		{
+			auto pending = pendingId(m_pendingCount.fetch_add(1, std::memory_order_relaxed));
+			record({ .kind = Kind::Create, .entity = pending });
+			return pending;
+		}
+
+		// returns a temporary id, only valid for commands of this buffer
+		auto clone(EntityId toClone) -> EntityId
+		{
+			auto pending = pendingId(m_pendingCount.fetch_add(1, std::memory_order_relaxed));
+			record({ .kind = Kind::Clone, .entity = pending, .source = toClone });
+			return pending;
+		}
+
+		void destroyEntity(EntityId entity)
+		{
+			record({ .kind = Kind::Destroy, .entity = entity });
+		}
+
+		// the component is constructed now and moved into the entity at playback
+		template <ConceptComponent T, typename... Args>
+		void add(EntityId entity, Args&&... args)
+		{
+			using Comp = std::remove_const_t<T>;
+			const int compId = m_manager->idFromType<Comp>();
+			withStream([&](Stream& stream) {
+				void* payload = stream.payloads.allocate(sizeof(Comp), alignof(Comp));
+				std::construct_at(static_cast<Comp*>(payload), std::forward<Args>(args)...);
+				stream.commands.push_back({
+					.kind = Kind::Add,
+					.compId = compId,
+					.entity = entity,
+					.type = typeid(Comp),
+					.payload = payload,
+					.relocate = [](void* to, void* from) { std::construct_at(static_cast<Comp*>(to), std::move(*static_cast<Comp*>(from))); },
+					.destroy = [](void* payload) { std::destroy_at(static_cast<Comp*>(payload)); },
+				});
+			});
+		}
+
+		template <ConceptComponent T>
+		void remove(EntityId entity)
+		{
+			using Comp = std::remove_const_t<T>;
+			record({ .kind = Kind::Remove, .compId = m_manager->idFromType<Comp>(), .entity = entity, .type = typeid(Comp) });
+		}
+
+		void remove(EntityId entity, std::type_index type)
+		{
+			int compId = m_manager->idFromType(type);
+			if (compId != ArkInvalidIndex)
+				record({ .kind = Kind::Remove, .compId = compId, .entity = entity, .type = type });
+		}
+
+		static bool isPending(EntityId entity) { return entity < ArkInvalidID; }
+
+		bool empty() const
+		{
+			return std::all_of(m_streams.begin(), m_streams.end(), [](auto& stream) { return stream->commands.empty(); });
+		}
+
+		/* applies every command, must be called from the main thread outside of any view iteration
+		 * commands recorded by signal handlers during playback are applied in the same call
+		*/
+		void playback()
+		{
+			while (!empty())
+				playbackRecorded();
+			for (auto& stream : m_streams)
+				stream->payloads.release();
+			m_created.clear();
+			m_pendingCount = 0;
+		}
+
+		// drops every command without applying it
+		void discard()
+		{
+			for (auto& stream : m_streams) {
+				for (auto& command : stream->commands)
+					if (command.payload)
+						command.destroy(command.payload);
+				stream->commands.clear();
+				stream->payloads.release();
+			}
+			m_created.clear();
+			m_pendingCount = 0;
+		}
+
+	private:
+		enum class Kind : std::uint8_t {
+			Create,
+			Clone,
+			Add,
+			Remove,
+			Destroy,
+		};
+
+		struct Command {
+			Kind kind;
+			int compId = ArkInvalidIndex;
+			EntityId entity = ArkInvalidID;
+			EntityId source = ArkInvalidID; // only for Clone
+			std::type_index type = typeid(void);
+			void* payload = nullptr; // only for Add
+			void (*relocate)(void* to, void* from) = nullptr;
+			void (*destroy)(void* payload) = nullptr;
+		};
+
+		struct Stream {
+			std::vector<Command> commands;
+			std::pmr::monotonic_buffer_resource payloads;
+		};
+
+		static auto pendingId(int index) -> EntityId { return ArkInvalidID - 1 - index; }
+		static auto pendingIndex(EntityId entity) -> int { return ArkInvalidID - 1 - entity; }
+
+		// the workers and the owner record without locking, the other threads share the last stream
+		template <typename F>
+		void withStream(F&& fun)
+		{
+			const auto index = JobSystem::global().threadIndex();
+			if (index < JobSystem::global().workerCount() || std::this_thread::get_id() == m_owner) {
+				fun(*m_streams[index]);
+				return;
+			}
+			std::scoped_lock lock(m_externalMutex);
+			fun(*m_streams.back());
+		}
+
+		void record(const Command& command)
+		{
+			withStream([&](Stream& stream) { stream.commands.push_back(command); });
+		}
+
+		auto resolve(EntityId entity) const -> EntityId
+		{
+			if (!isPending(entity))
+				return entity;
+			auto index = pendingIndex(entity);
+			return index < m_created.size() ? m_created[index] : ArkInvalidID;
+		}
+
+		bool isDestroyed(EntityId entity) const
+		{
+			return std::binary_search(m_destroyed.begin(), m_destroyed.end(), entity);
+		}
+
+		static void dropPayload(Command& command)
+		{
+			command.destroy(command.payload);
+			command.payload = nullptr;
+		}
+
+		void playbackRecorded()
+		{
+			auto& manager = *m_manager;
+			m_commands.clear();
+			for (auto& stream : m_streams) {
+				m_commands.insert(m_commands.end(), stream->commands.begin(), stream->commands.end());
+				stream->commands.clear();
+			}
+
+			// 1. create, all at once, then clone
+			m_created.resize(m_pendingCount.load(std::memory_order_relaxed), ArkInvalidID);
+			const auto createCount = std::count_if(m_commands.begin(), m_commands.end(), [](const Command& command) {
+				return command.kind == Kind::Create;
+			});
+			if (createCount > 0) {
+				auto created = manager.createEntities(createCount);
+				auto next = created.begin();
+				for (const auto& command : m_commands)
+					if (command.kind == Kind::Create)
+						m_created[pendingIndex(command.entity)] = *next++;
+			}
+			for (auto& command : m_commands) {
+				if (command.kind == Kind::Clone) {
+					auto source = resolve(command.source);
+					if (manager.isValid(source))
+						m_created[pendingIndex(command.entity)] = manager.clone(source).getID();
+					else
+						EngineLog(LogSource::EntityM, LogLevel::Warning, "CommandBuffer: clone of invalid entity (%d) ignored", command.source);
+				}
+			}
+
+			m_destroyed.clear();
+			for (auto& command : m_commands) {
+				command.entity = resolve(command.entity);
+				if (command.kind == Kind::Destroy && manager.isValid(command.entity))
+					m_destroyed.push_back(command.entity);
+			}
+			std::sort(m_destroyed.begin(), m_destroyed.end());
+			m_destroyed.erase(std::unique(m_destroyed.begin(), m_destroyed.end()), m_destroyed.end());
+
+			// 2. add/remove grupate pe (componenta, entitate), stable_sort pastreaza ordinea inregistrarii in grup
+			std::erase_if(m_commands, [this, &manager](Command& command) {
+				if (command.kind != Kind::Add && command.kind != Kind::Remove)
+					return true;
+				if (!manager.isValid(command.entity) || isDestroyed(command.entity)) {
+					if (command.payload)
+						dropPayload(command);
+					return true;
+				}
+				return false;
+			});
+			std::stable_sort(m_commands.begin(), m_commands.end(), [](const Command& a, const Command& b) {
+				return a.compId != b.compId ? a.compId < b.compId : a.entity < b.entity;
+			});
+
+			for (auto run = m_commands.begin(); run != m_commands.end();) {
+				auto runEnd = std::find_if(run, m_commands.end(), [&](const Command& command) {
+					return command.compId != run->compId;
+				});
+				applyRun(std::span<Command>(run, runEnd));
+				run = runEnd;
+			}
+
+			// 3. destroy
+			manager.destroyEntities(m_destroyed);
+		}
+
+		// the commands of one component type, sorted by entity; the removes are applied first, then the adds in one batch
+		void applyRun(std::span<Command> run)
+		{
+			auto& manager = *m_manager;
+			const auto compId = run.front().compId;
+			m_addEntities.clear();
+			m_adds.clear();
+			for (auto group = run.begin(); group != run.end();) {
+				auto groupEnd = std::find_if(group, run.end(), [&](const Command& command) { return command.entity != group->entity; });
+				if (auto* add = applyGroup(std::span<Command>(group, groupEnd))) {
+					m_addEntities.push_back(add->entity);
+					m_adds.push_back(add);
+				}
+				group = groupEnd;
+			}
+			if (m_adds.empty())
+				return;
+
+			// the remove signals of this run can destroy entities or add the component
+			std::size_t kept = 0;
+			for (std::size_t i = 0; i < m_adds.size(); i++) {
+				const auto entity = m_addEntities[i];
+				if (!manager.isValid(entity) || manager.mask(entity).test(compId))
+					dropPayload(*m_adds[i]);
+				else {
+					m_addEntities[kept] = entity;
+					m_adds[kept++] = m_adds[i];
+				}
+			}
+			m_addEntities.resize(kept);
+			m_adds.resize(kept);
+			if (m_adds.empty())
+				return;
+
+			m_addPayloads.clear();
+			for (auto* add : m_adds)
+				m_addPayloads.push_back(add->payload);
+			manager.implRelocateAddBatch(compId, m_adds.front()->type, m_addEntities, m_addPayloads, m_adds.front()->relocate);
+			for (auto* add : m_adds)
+				dropPayload(*add);
+		}
+
+		/* commands for the same component of the same entity, in recording order
+		 * applies the remove, returns the add left to apply (nullptr if none)
+		*/
+		auto applyGroup(std::span<Command> group) -> Command*
+		{
+			auto& manager = *m_manager;
+			const auto entity = group.front().entity;
+			const auto compId = group.front().compId;
+			// semnalele grupurilor anterioare pot distruge entitatea
+			if (!manager.isValid(entity)) {
+				for (auto& command : group)
+					if (command.payload)
+						dropPayload(command);
+				return nullptr;
+			}
+
+			bool has = manager.mask(entity).test(compId);
+			bool removeExisting = false;
+			Command* add = nullptr;
+			for (auto& command : group) {
+				if (command.kind == Kind::Add) {
+					if (has)
+						dropPayload(command);
+					else {
+						add = &command;
+						has = true;
+					}
+				}
+				else if (has) {
+					if (add) {
+						dropPayload(*add);
+						add = nullptr;
+					}
+					else
+						removeExisting = true;
+					has = false;
+				}
+			}
+
+			if (removeExisting)
+				manager.remove(entity, group.front().type);
+			return add;
+		}
+
+	private:
+		EntityManager* m_manager;
+		std::vector<std::unique_ptr<Stream>> m_streams; // index = JobSystem::global().threadIndex(), the last one for the other threads
+		const std::thread::id m_owner;
+		std::mutex m_externalMutex;
+		std::atomic<int> m_pendingCount = 0; // ids returned by createEntity/clone since the last playback
+		// folosite doar in playback, tinute ca membri ca sa nu realocam la fiecare frame
+		std::vector<Command> m_commands;
+		std::vector<EntityId> m_created; // pending index -> entity id
+		std::vector<EntityId> m_destroyed;
+		std::vector<EntityId> m_addEntities; // the adds of the current component type
+		std::vector<Command*> m_adds;
+		std::vector<void*> m_addPayloads;
+	};
+}
@@ -8,6 +8,8 @@
 #include <any>
 #include <memory>
 #include <memory_resource>
+#include <cstdint>
+#include <tuple>
 
 #include "ark/core/Core.hpp"
 #include "ark/core/Logger.hpp"
@@ -26,4 +28,117 @@ namespace ark {
 
 	static inline constexpr std::size_t MaxComponentTypes = 32;
 	using ComponentMask = std::bitset<MaxComponentTypes>;
+
+	/* Change detection
+	 *
+	 * Every component has two ticks: when it was added and when it was last accessed for writing
+	 * (non-const get/tryGet, iteration of a non-const view term, patch). The manager's tick is advanced
+	 * by SystemManager after each system update, so View<Changed<T>> in a system yields only the components
+	 * touched since that system's previous update (its own writes are not reported back to it).
+	 *
+	 * A write through a pointer/reference kept from an older access is not seen, get the component again
+	 * (or use patch) when the change should be visible.
+	*/
+	using ChangeTick = std::uint32_t;
+
+	struct ComponentTicks {
+		ChangeTick added = 0;
+		ChangeTick changed = 0;
+	};
+
+	// 'tick' happened after 'since', correct across the wrap-around of the counter
+	constexpr bool isNewer(ChangeTick tick, ChangeTick since) noexcept
+	{
+		return static_cast<std::int32_t>(tick - since) > 0;
+	}
+
+	/* view filters, View<Changed<const Transform>, Sprite> yields 'const Transform&' and 'Sprite&' like View<const Transform, Sprite>
+	 * but only for entities whose Transform was changed since the tick of the view (see View::setSince)
+	*/
+	template <ConceptComponent T>
+	struct Changed {};
+
+	// like Changed, for components added since the tick of the view
+	template <ConceptComponent T>
+	struct Added {};
+
+	/* View<Sprite, Without<Hidden>> skips the entities that have Hidden, the test is done on the whole mask
+	 * Without<T> gives nothing to the callbacks
+	*/
+	template <ConceptComponent T>
+	struct Without {};
+
+	/* View<Sprite, Maybe<Outline>> yields 'Outline*', nullptr for the entities without Outline
+	 * Maybe<T> doesn't change which entities are iterated
+	*/
+	template <ConceptComponent T>
+	struct Maybe {};
+
+	enum class ViewFilter : std::uint8_t {
+		None,
+		Changed,
+		Added,
+	};
+
+	enum class ViewTermKind : std::uint8_t {
+		Required,
+		Excluded, // Without<T>
+		Optional, // Maybe<T>
+	};
+
+	namespace detail {
+		template <typename T>
+		struct view_term {
+			using component = T;
+			static constexpr ViewFilter filter = ViewFilter::None;
+			static constexpr ViewTermKind kind = ViewTermKind::Required;
+		};
+
+		template <typename T>
+		struct view_term<Changed<T>> {
+			using component = T;
+			static constexpr ViewFilter filter = ViewFilter::Changed;
+			static constexpr ViewTermKind kind = ViewTermKind::Required;
+		};
+
+		template <typename T>
+		struct view_term<Added<T>> {
+			using component = T;
+			static constexpr ViewFilter filter = ViewFilter::Added;
+			static constexpr ViewTermKind kind = ViewTermKind::Required;
+		};
+
+		template <typename T>
+		struct view_term<Without<T>> {
+			using component = T;
+			static constexpr ViewFilter filter = ViewFilter::None;
+			static constexpr ViewTermKind kind = ViewTermKind::Excluded;
+		};
+
+		template <typename T>
+		struct view_term<Maybe<T>> {
+			using component = T;
+			static constexpr ViewFilter filter = ViewFilter::None;
+			static constexpr ViewTermKind kind = ViewTermKind::Optional;
+		};
+	}
+
+	// component type of a view term: Changed<const T> -> const T
+	template <typename T>
+	using view_component_t = typename detail::view_term<T>::component;
+
+	template <typename T>
+	constexpr ViewTermKind view_term_kind_v = detail::view_term<T>::kind;
+
+	// what a term gives to the callbacks: std::tuple<T&>, std::tuple<T*> for Maybe<T>, std::tuple<> for Without<T>
+	template <typename T>
+	using view_term_yield_t = std::conditional_t<view_term_kind_v<T> == ViewTermKind::Excluded, std::tuple<>,
+		std::conditional_t<view_term_kind_v<T> == ViewTermKind::Optional, std::tuple<view_component_t<T>*>, std::tuple<view_component_t<T>&>>>;
+
+	// View<Cs...> yields the concatenation of its terms
+	template <typename... Ts>
+	using view_yield_t = decltype(std::tuple_cat(std::declval<view_term_yield_t<Ts>>()...));
+
+	template <typename T>
+	concept ConceptViewTerm = ConceptComponent<view_component_t<T>>;
 }
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <vector>
+#include <span>
+#include <bit>
+#include <algorithm>
+#include <memory_resource>
+
+#include "ark/ecs/Component.hpp"
+#include "ark/ecs/Entity.hpp"
+
+namespace ark {
+
+	/* Sparse set type-erased pentru un singur tip de componenta
+	 *
+	 * sparse: entity id -> index in dense
+	 * dense:  index -> entity id (ArkInvalidID daca slot-ul e liber)
+	 * componentele stau in pagini de marime fixa, slot-ul 'i' din dense are componenta in pagina i / PageSize
+	 * fiecare tip are paginile lui (un slab per tip), marimea si alinierea vin din meta::Metadata
+	 *
+	 * Stergerea nu muta alte componente (slot-ul devine liber si e refolosit de urmatorul emplace),
+	 * deci pointerii catre componente raman valizi pana la remove-ul componentei respective.
+	 * Asta conteaza pentru scripturile care tin pointeri in bind().
+	 * Singura exceptie e compact(), apelat explicit prin EntityManager::compact().
+	 *
+	 * ticks: index -> ComponentTicks, paralel cu dense
+	*/
+	class ComponentPool final : public NonCopyable {
+	public:
+		static constexpr std::size_t PageBytes = 4096;
+		static constexpr std::size_t MinPageCapacity = 8; // componentele mari au pagini mai mari, nu una per componenta
+		static constexpr int Tombstone = ArkInvalidID;
+
+		ComponentPool(const meta::Metadata& metadata, std::pmr::memory_resource* resource)
+			: m_metadata(&metadata), m_resource(resource),
+			m_pageCapacity(std::bit_floor(std::max<std::size_t>(MinPageCapacity, PageBytes / metadata.size))),
+			m_pageShift(std::countr_zero(m_pageCapacity))
+		{ }
+
+		~ComponentPool()
+		{
+			clear();
+			for (void* page : m_pages)
+				m_resource->deallocate(page, pageBytes(), m_metadata->align);
+		}
+
+		// returns uninitialized memory for entity's component, the caller must construct it
+		// the entity must not already have a component in this pool
+		void* emplace(Entity::ID entity, ChangeTick tick)
+		{
+			int index;
+			if (!m_freeSlots.empty()) {
+				index = m_freeSlots.back();
+				m_freeSlots.pop_back();
+				m_dense[index] = entity;
+				m_ticks[index] = { tick, tick };
+			} else {
+				index = static_cast<int>(m_dense.size());
+				if (m_dense.size() == m_pages.size() * m_pageCapacity)
+					m_pages.push_back(m_resource->allocate(pageBytes(), m_metadata->align));
+				m_dense.push_back(entity);
+				m_ticks.push_back({ tick, tick });
+			}
+			if (entity >= m_sparse.size())
+				m_sparse.resize(entity + 1, ArkInvalidIndex);
+			m_sparse[entity] = index;
+			m_size++;
+			return at(index);
+		}
+
+		// makes room for 'count' more components and for entity ids up to 'maxEntity'
+		void reserve(std::size_t count, Entity::ID maxEntity)
+		{
+			// slot-urile libere sunt folosite primele
+			const auto slots = m_dense.size() + (count > m_freeSlots.size() ? count - m_freeSlots.size() : 0);
+			m_dense.reserve(slots);
+			m_ticks.reserve(slots);
+			while (m_pages.size() * m_pageCapacity < slots)
+				m_pages.push_back(m_resource->allocate(pageBytes(), m_metadata->align));
+			if (maxEntity >= m_sparse.size())
+				m_sparse.resize(maxEntity + 1, ArkInvalidIndex);
+		}
+
+		// destroys the component, the slot is reused by later emplace calls
+		void erase(Entity::ID entity)
+		{
+			int index = m_sparse[entity];
+			void* component = at(index);
+			if (m_metadata->destructor)
+				m_metadata->destructor(component);
+			m_sparse[entity] = ArkInvalidIndex;
+			m_dense[index] = Tombstone;
+			m_freeSlots.push_back(index);
+			m_size--;
+		}
+
+		void clear()
+		{
+			for (int i = 0; i < m_dense.size(); i++) {
+				if (m_dense[i] != Tombstone && m_metadata->destructor)
+					m_metadata->destructor(at(i));
+			}
+			m_dense.clear();
+			m_ticks.clear();
+			m_sparse.clear();
+			m_freeSlots.clear();
+			m_size = 0;
+		}
+
+		/* moves the last components into the free slots so the live ones are contiguous again
+		 * and releases the pages that are no longer needed; the ticks move with the components
+		 * invalidates the pointers to the moved components, returns true if any component was moved
+		*/
+		bool compact()
+		{
+			if (!m_metadata->move_constructor)
+				return false;
+			std::sort(m_freeSlots.begin(), m_freeSlots.end());
+			bool moved = false;
+			std::size_t end = m_dense.size();
+			for (int hole : m_freeSlots) {
+				while (end > 0 && m_dense[end - 1] == Tombstone)
+					end--;
+				if (hole >= end)
+					break;
+				const auto last = --end;
+				m_metadata->move_constructor(at(hole), at(last));
+				if (m_metadata->destructor)
+					m_metadata->destructor(at(last));
+				m_dense[hole] = m_dense[last];
+				m_ticks[hole] = m_ticks[last];
+				m_sparse[m_dense[hole]] = hole;
+				m_dense[last] = Tombstone;
+				moved = true;
+			}
+			m_dense.resize(m_size);
+			m_ticks.resize(m_size);
+			m_freeSlots.clear();
+			const auto pages = (m_size + m_pageCapacity - 1) / m_pageCapacity;
+			while (m_pages.size() > pages) {
+				m_resource->deallocate(m_pages.back(), pageBytes(), m_metadata->align);
+				m_pages.pop_back();
+			}
+			return moved;
+		}
+
+		bool contains(Entity::ID entity) const noexcept
+		{
+			return entity >= 0 && entity < m_sparse.size() && m_sparse[entity] != ArkInvalidIndex;
+		}
+
+		void* tryGet(Entity::ID entity) const noexcept
+		{
+			return contains(entity) ? at(m_sparse[entity]) : nullptr;
+		}
+
+		// also marks the component as changed at 'tick'
+		void* tryGet(Entity::ID entity, ChangeTick tick) noexcept
+		{
+			if (!contains(entity))
+				return nullptr;
+			int index = m_sparse[entity];
+			m_ticks[index].changed = tick;
+			return at(index);
+		}
+
+		void* get(Entity::ID entity) const noexcept
+		{
+			return at(m_sparse[entity]);
+		}
+
+		// the entity must have a component in this pool
+		auto ticks(Entity::ID entity) noexcept -> ComponentTicks& { return m_ticks[m_sparse[entity]]; }
+		auto ticks(Entity::ID entity) const noexcept -> const ComponentTicks& { return m_ticks[m_sparse[entity]]; }
+
+		void* at(std::size_t index) const noexcept
+		{
+			auto* page = static_cast<std::byte*>(m_pages[index >> m_pageShift]);
+			return page + (index & (m_pageCapacity - 1)) * m_metadata->size;
+		}
+
+		// slot -> entity, tombstones are marked with ComponentPool::Tombstone
+		auto entities() const noexcept -> std::span<const Entity::ID> { return m_dense; }
+
+		// number of live components
+		auto size() const noexcept -> std::size_t { return m_size; }
+
+		auto metadata() const noexcept -> const meta::Metadata& { return *m_metadata; }
+
+	private:
+		auto pageBytes() const noexcept -> std::size_t { return m_pageCapacity * m_metadata->size; }
+
+	private:
+		const meta::Metadata* m_metadata;
+		std::pmr::memory_resource* m_resource;
+		std::size_t m_pageCapacity; // componente per pagina, putere a lui 2
+		int m_pageShift;
+		std::size_t m_size = 0;
+		std::vector<void*> m_pages;
+		std::vector<int> m_sparse;
+		std::vector<Entity::ID> m_dense;
+		std::vector<ComponentTicks> m_ticks;
+		std::vector<int> m_freeSlots;
+	};
+}
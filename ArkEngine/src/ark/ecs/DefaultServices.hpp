@@ -1,12 +1,16 @@
 #pragma once
 
 #include "ark/ecs/SerdeJsonDirector.hpp"
+#include "ark/ecs/SerdeJsonStream.hpp"
+#include "ark/ecs/SerdeBinaryDirector.hpp"
 
 template <typename T>
 inline void addSerdeFunctions() {
 	auto* type = ark::meta::type<T>();
 	type->func(ark::serde::serviceSerializeName, ark::serde::serialize_value<T>);
 	type->func(ark::serde::serviceDeserializeName, ark::serde::deserialize_value<T>);
+	type->data(ark::serde::serviceJsonName, ark::serde::JsonTypeGetter{ ark::serde::jsonType<T> });
+	type->data(ark::serde::serviceBinaryName, ark::serde::BinaryTypeGetter{ ark::serde::binaryType<T> });
 }
 
 template <typename T>
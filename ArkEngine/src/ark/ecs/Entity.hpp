@@ -10,6 +10,7 @@ namespace ark {
 	struct RuntimeComponent {
 		std::type_index type = typeid(void);
 		void* ptr = nullptr;
+		const meta::Metadata* metadata = nullptr;
 	};
 
 	class ProxyRuntimeComponentView;
@@ -48,12 +49,21 @@ namespace ark {
 
 		void add(std::type_index type, Entity entity = {});
 
+		// the Metadata overloads don't have to hash the type, prefer them when the Metadata is at hand
+		void add(const meta::Metadata& mdata, Entity entity = {});
+
 		void* get(std::type_index type);
 
 		const void* get(std::type_index type) const {
 			return const_cast<Entity*>(this)->get(type);
 		}
 
+		void* get(const meta::Metadata& mdata);
+
+		const void* get(const meta::Metadata& mdata) const {
+			return const_cast<Entity*>(this)->get(mdata);
+		}
+
 		template <ConceptComponent... Ts>
 		decltype(auto) get() const {
 			static_assert(sizeof...(Ts) > 0, "trebuie sa ai argumente");
@@ -81,6 +91,10 @@ namespace ark {
 		[[nodiscard]]
 		const T* tryGet() const;
 
+		// marks the component as changed and calls fun(T&), returns false if the component is not found
+		template <ConceptComponent T, std::invocable<T&> F>
+		bool patch(F&& fun);
+
 		template <typename F>
 		requires std::invocable<F, RuntimeComponent>
 		void eachComponent(F&& f);
@@ -92,6 +106,8 @@ namespace ark {
 
 		void remove(std::type_index type);
 
+		void remove(const meta::Metadata& mdata);
+
 	public:
 		[[nodiscard]]
 		auto getMask() const -> ComponentMask;
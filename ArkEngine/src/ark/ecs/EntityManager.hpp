@@ -10,13 +10,19 @@
 #include <array>
 #include <span>
 #include <ranges>
+#include <cstring>
 
 #include "ark/ecs/Component.hpp"
 #include "ark/ecs/Entity.hpp"
+#include "ark/ecs/ComponentPool.hpp"
+#include "ark/ecs/ArchetypeManager.hpp"
 #include "ark/core/Signal.hpp"
+#include "ark/core/JobSystem.hpp"
 
 namespace ark {
 
+	class Snapshot;
+
 	class ProxyEntitiesView;
 	class ProxyRuntimeComponentView;
 
@@ -24,6 +30,73 @@ namespace ark {
 
 	using EntityId = int;
 
+	/* SparseSet: un pool per tip de componenta, pointerii catre componente sunt stabili
+	 * Archetype: componentele entitatilor cu aceeasi masca stau impreuna in chunk-uri (vezi ArchetypeManager.hpp),
+	 *            iterarea e secventiala dar add/remove muta componentele, deci pointerii nu sunt stabili
+	*/
+	enum class StoragePolicy {
+		SparseSet,
+		Archetype,
+	};
+
+	struct StorageOptions {
+		StoragePolicy policy = StoragePolicy::SparseSet;
+		std::size_t chunkSize = ArchetypeManager::DefaultChunkSize; // only for StoragePolicy::Archetype
+	};
+
+	/* the entities of a view: every component of 'include' and none of 'exclude' (Without<T>)
+	 * Maybe<T> terms are in neither mask
+	*/
+	struct ViewMask {
+		ComponentMask include;
+		ComponentMask exclude;
+
+		bool matches(const ComponentMask& mask) const noexcept { return (mask & include) == include && (mask & exclude).none(); }
+	};
+
+	/* Changed/Added terms of a view as component masks, so that view.each<...>() with other components keeps them
+	 * an entity passes if every filtered component was changed/added after 'since'
+	*/
+	struct ViewFilters {
+		ComponentMask changed;
+		ComponentMask added;
+		ChangeTick since = 0;
+
+		bool empty() const noexcept { return changed.none() && added.none(); }
+
+		// the tick columns to check in one archetype chunk
+		struct Chunk {
+			std::array<const ComponentTicks*, 2 * MaxComponentTypes> columns{};
+			std::array<bool, 2 * MaxComponentTypes> added{};
+			int count = 0;
+			ChangeTick since = 0;
+
+			bool passes(std::size_t row) const noexcept
+			{
+				for (int i = 0; i < count; i++)
+					if (!isNewer(added[i] ? columns[i][row].added : columns[i][row].changed, since))
+						return false;
+				return true;
+			}
+		};
+
+		auto chunk(const ArchetypeManager::Archetype& arch, std::size_t chunk) const noexcept -> Chunk
+		{
+			Chunk filter{ .since = since };
+			for (int compId = 0; compId < MaxComponentTypes; compId++) {
+				if (changed.test(compId)) {
+					filter.columns[filter.count] = arch.ticks(chunk, arch.columnOf[compId]);
+					filter.added[filter.count++] = false;
+				}
+				if (added.test(compId)) {
+					filter.columns[filter.count] = arch.ticks(chunk, arch.columnOf[compId]);
+					filter.added[filter.count++] = true;
+				}
+			}
+			return filter;
+		}
+	};
+
 	namespace detail
 	{ 
 		inline auto& s_counter() {
@@ -43,71 +116,237 @@ namespace ark {
 			return detail::s_counter()++;
 		}();
 	public:
+		/* a handler every EntityManager connects to onAdd<T>() when it registers T, before any other handler
+		 * ark::meta::type<T>()->data(ark::EntityManager::serviceOnAddName, ark::EntityManager::OnAddService{ T::onAdd });
+		*/
+		static inline constexpr std::string_view serviceOnAddName = "on_add";
+		using OnAddService = void (*)(EntityManager&, EntityId);
+
 		EntityManager(			
 			std::pmr::memory_resource* upstreamComponent = std::pmr::new_delete_resource())
-			: m_componentPool(std::make_unique<std::pmr::unsynchronized_pool_resource>(
-				std::pmr::pool_options{.max_blocks_per_chunk = 100, .largest_required_pool_block = 1024},
-				upstreamComponent))
+			: EntityManager(StorageOptions{}, upstreamComponent) { }
+
+		EntityManager(
+			StorageOptions options,
+			std::pmr::memory_resource* upstreamComponent = std::pmr::new_delete_resource())
+			: m_componentResource(upstreamComponent)
 		{
+			if (options.policy == StoragePolicy::Archetype)
+				m_archetypes = std::make_unique<ArchetypeManager>(options.chunkSize, m_componentResource);
 			m_componentsNum = detail::s_counter();
-			int i = 0;
-			for (auto& type : componentIds()) {
+			for (int i = 0; i < MaxComponentTypes; i++) {
 				if (i < detail::s_counter())
-					type = detail::s_ids()[i];
+					registerComponentId(i, detail::s_ids()[i]);
 				else
-					type = typeid(void);
-				i++;
+					componentIds()[i] = typeid(void);
 			}
 		}
 
-		EntityManager(EntityManager&&) noexcept = default;
+		/* not movable: the structure lock and the change tick are atomics, and the views, command buffers,
+		 * systems and signal payloads keep a pointer to the manager, they would all be left dangling
+		*/
+		EntityManager(EntityManager&&) = delete;
 
 		EntityManager(const EntityManager&) = delete;
 
 		auto createEntity() -> Entity
 		{
-			EntityId id;
-			if (m_freeEntities.size() > 0) {
-				id = m_freeEntities.back();
-				m_freeEntities.pop_back();
-				m_isFree[id] = false;
-			} else {
-				id = m_entities.size();
-				m_entities.emplace_back();
-				m_isFree.push_back(false);
-				m_masks.emplace_back();
-			}
+			checkStructuralChange("createEntity");
+			EntityId id = allocateEntity();
 			auto e = Entity(id, this);
-			auto& entity = getEntity(e);
-			entity.id = id;
 			m_signalCreate.publish(*this, e);
+			if (m_signalCreateBatch.size())
+				m_signalCreateBatch.publish(*this, std::span<const EntityId>(&id, 1));
 			return e;
 		}
 
+		/* creates 'count' entities, each with a copy of 'prototypes'
+		 * storage is reserved once and the components are constructed type by type
+		 * signals are published after every entity got its components: onCreateBatch/onAddBatch once with all the entities,
+		 * onCreate/onAdd per entity only if someone is connected to them
+		*/
+		template <ConceptComponent... Cs>
+		auto createEntities(std::size_t count, const Cs&... prototypes) -> std::vector<EntityId>
+		{
+			checkStructuralChange("createEntities");
+			std::vector<EntityId> entities(count);
+			if (count == 0)
+				return entities;
+
+			m_masks.reserve(m_masks.size() + count);
+			m_isFree.reserve(m_isFree.size() + count);
+			EntityId maxEntity = ArkInvalidID;
+			for (auto& id : entities) {
+				id = allocateEntity();
+				maxEntity = std::max(maxEntity, id);
+			}
+
+			ComponentMask mask;
+			(mask.set(idFromType<Cs>()), ...);
+			for (auto id : entities)
+				m_masks[id] = mask;
+
+			if constexpr (sizeof...(Cs) > 0) {
+				if (m_archetypes) {
+					(m_archetypes->setMetadata(idFromType<Cs>(), *meta::resolve<Cs>()), ...);
+					m_archetypes->reserve(mask, count);
+					for (auto id : entities)
+						m_archetypes->insert(id, mask, changeTick());
+					(constructBulk<Cs>(entities, [this](EntityId id, int compId) { return m_archetypes->get(id, compId); }, prototypes), ...);
+				}
+				else {
+					(pool(idFromType<Cs>(), typeid(Cs)).reserve(count, maxEntity), ...);
+					(constructBulk<Cs>(entities, [this](EntityId id, int compId) { return m_pools[compId]->emplace(id, changeTick()); }, prototypes), ...);
+				}
+			}
+
+			const std::span<const EntityId> span = entities;
+			if (m_signalCreate.size())
+				for (auto id : entities)
+					m_signalCreate.publish(*this, Entity{ id, this });
+			m_signalCreateBatch.publish(*this, span);
+			(publishAddBulk(idFromType<Cs>(), typeid(Cs), span), ...);
+			return entities;
+		}
+
+		// createEntities<Transform, Drawable>(n) with default constructed components
+		template <ConceptComponent... Cs>
+		requires (sizeof...(Cs) > 0)
+		auto createEntities(std::size_t count) -> std::vector<EntityId>
+		{
+			return createEntities(count, Cs{}...);
+		}
+
 		/* First, construct each component with default or copy constructor
 		 * Then, call the clone signals for each component that has them
 		*/
 		auto clone(ark::EntityId toClone) -> ark::Entity {
 			auto clone = createEntity();
 			eachComponent(toClone, [&](RuntimeComponent comp) {
-				add(clone, comp.type, toClone);
+				add(clone, *comp.metadata, toClone);
 			});
 			eachComponent(toClone, [&](RuntimeComponent comp) {
-				signalTable(m_tableClone, comp.type, clone, ark::Entity{ toClone, this });
+				m_tableClone[idFromType(*comp.metadata)].publish(clone, ark::Entity{ toClone, this });
 			});
 			return clone;
 		}
 
+		/* 'count' clones of 'prototype', e.g. spawning bullets from a template entity
+		 * the components of the prototype are looked up once, storage is reserved once per type,
+		 * trivially copyable components are copied with memcpy, the rest like clone()
+		 * signals are published after every clone got its components, like createEntities,
+		 * then onCloneBatch once per component type and onClone per entity only if someone is connected to it
+		*/
+		auto instantiate(EntityId prototype, std::size_t count) -> std::vector<EntityId>
+		{
+			checkStructuralChange("instantiate");
+			if (!isValid(prototype)) {
+				EngineLog(LogSource::EntityM, LogLevel::Error, "instantiate: entity (%d) is not valid", prototype);
+				return {};
+			}
+			std::vector<EntityId> entities(count);
+			if (count == 0)
+				return entities;
+
+			const auto mask = m_masks[prototype];
+			m_masks.reserve(m_masks.size() + count);
+			m_isFree.reserve(m_isFree.size() + count);
+			EntityId maxEntity = ArkInvalidID;
+			for (auto& id : entities) {
+				id = allocateEntity();
+				maxEntity = std::max(maxEntity, id);
+				m_masks[id] = mask;
+			}
+
+			std::vector<int> compIds;
+			for (int compId = 0; compId < MaxComponentTypes; compId++)
+				if (mask.test(compId))
+					compIds.push_back(compId);
+
+			const auto tick = changeTick();
+			if (m_archetypes) {
+				m_archetypes->reserve(mask, count);
+				for (auto id : entities)
+					m_archetypes->insert(id, mask, tick);
+			}
+			else
+				for (int compId : compIds)
+					m_pools[compId]->reserve(count, maxEntity);
+
+			for (int compId : compIds) {
+				const auto* mdata = m_metadata[compId];
+				const void* source = tryComponent(prototype, compId);
+				for (auto id : entities) {
+					void* memory = m_archetypes ? m_archetypes->get(id, compId) : m_pools[compId]->emplace(id, tick);
+					if (mdata->trivially_copyable)
+						std::memcpy(memory, source, mdata->size);
+					else if (mdata->copy_constructor)
+						mdata->copy_constructor(memory, source);
+					else
+						mdata->default_constructor(memory);
+				}
+			}
+
+			const std::span<const EntityId> span = entities;
+			if (m_signalCreate.size())
+				for (auto id : entities)
+					m_signalCreate.publish(*this, Entity{ id, this });
+			m_signalCreateBatch.publish(*this, span);
+			for (int compId : compIds)
+				publishAddBulk(compId, typeFromId(compId), span);
+			for (int compId : compIds) {
+				if (m_tableClone[compId].size())
+					for (auto id : entities)
+						m_tableClone[compId].publish(Entity{ id, this }, Entity{ prototype, this });
+				m_tableCloneBatch[compId].publish(*this, span, Entity{ prototype, this });
+			}
+			return entities;
+		}
+
 		bool isValid(EntityId entity) const {
-			return entity != ArkInvalidID && entity >= 0 && !m_isFree[entity];
+			return entity >= 0 && entity < static_cast<EntityId>(m_isFree.size()) && !m_isFree[entity];
 		}
 
 		void reserveEntities(int num) {
-			m_entities.reserve(num);
 			m_isFree.reserve(num);
 			m_masks.reserve(num);
 		}
 
+		/* Pointer stability
+		 *
+		 * StoragePolicy::SparseSet: a pointer/reference to a component stays valid until that component is removed
+		 * (or its entity destroyed), other adds/removes don't move it. compact() is the only exception.
+		 * StoragePolicy::Archetype: any structural change can move components, don't keep pointers (see ArchetypeManager.hpp).
+		 *
+		 * compact() moves components with their move constructor to fill the holes left by removed components,
+		 * so each type is contiguous again after heavy churn, and releases the unused pages/chunks.
+		 * Every pointer to a component may be invalid afterwards (Transform links its parent/children by entity id, so it is not affected),
+		 * onCompact is published so the caches can be rebuilt. Call it at a sync point, e.g. between levels or after a big despawn,
+		 * never during a view iteration or a system update.
+		*/
+		void compact()
+		{
+			checkStructuralChange("compact");
+			if (m_archetypes) {
+				m_archetypes->shrink();
+				return;
+			}
+			bool moved = false;
+			for (auto& pool : m_pools)
+				if (pool)
+					moved |= pool->compact();
+			if (moved)
+				m_signalCompact.publish(*this);
+		}
+
+		/* the whole world in one buffer: entities, masks, free list and every component
+		 * restore() destroys the current entities (with the destroy/remove signals) and recreates the ones from the snapshot
+		 * with the same ids, then publishes onCreate/onAdd like createEntities; the components are marked as added now.
+		 * defined in Snapshot.hpp, include it to use them
+		*/
+		auto snapshot() const -> Snapshot;
+		void restore(const Snapshot& snapshot);
+
 		/* function type should be void(EntityManager&, Entity/EntityId)
 		*/
 		auto onCreate() {
@@ -118,19 +357,51 @@ namespace ark {
 			return Sink{ m_signalDestroy };
 		}
 
+		/* function type should be void(EntityManager&, std::span<const EntityId>)
+		 * published once per createEntities/destroyEntities call and with a single entity for createEntity/destroyEntity
+		*/
+		auto onCreateBatch() {
+			return Sink{ m_signalCreateBatch };
+		}
+
+		auto onDestroyBatch() {
+			return Sink{ m_signalDestroyBatch };
+		}
+
+		/* function type should be void(EntityManager&)
+		 * published by compact() after components were moved, whoever keeps component pointers must get them again
+		*/
+		auto onCompact() {
+			return Sink{ m_signalCompact };
+		}
+
+		// published once per createEntities call, type by type
+		template <ConceptComponent T>
+		auto onAddBatch() {
+			return Sink{ m_tableAddBatch[idFromType<T>()] };
+		}
+
 		template <ConceptComponent T>
 		auto onAdd() {
-			return Sink{ m_tableAdd[typeid(T)] };
+			return Sink{ m_tableAdd[idFromType<T>()] };
 		}
 
 		template <ConceptComponent T>
 		auto onClone() {
-			return Sink{ m_tableClone[typeid(T)] };
+			return Sink{ m_tableClone[idFromType<T>()] };
+		}
+
+		/* function type should be void(EntityManager&, std::span<const EntityId> clones, Entity prototype)
+		 * published once per instantiate call
+		*/
+		template <ConceptComponent T>
+		auto onCloneBatch() {
+			return Sink{ m_tableCloneBatch[idFromType<T>()] };
 		}
 
 		template <ConceptComponent T>
 		auto onRemove() {
-			return Sink{ m_tableRemove[typeid(T)] };
+			return Sink{ m_tableRemove[idFromType<T>()] };
 		}
 
 		/* for .patch<T>(auto& comp) { comp.mem = nush; }
@@ -153,18 +424,31 @@ namespace ark {
 
 		void destroyEntity(EntityId entityId)
 		{
-			m_signalDestroy.publish(*this, Entity{ entityId, this });
-			this->eachComponent(entityId, [&, this](RuntimeComponent comp) {
-				this->remove(entityId, comp.type);
-			});
-			m_isFree[entityId] = true;
-			m_freeEntities.push_back(entityId);
+			checkStructuralChange("destroyEntity");
+			implDestroyEntities(std::span<const EntityId>(&entityId, 1));
 		}
 
-		template <ConceptComponent... Ts>
+		/* destroys the valid entities from 'entities', duplicates are ignored
+		 * onDestroyBatch is published once, onDestroy/onRemove per entity only if someone is connected to them
+		*/
+		void destroyEntities(std::span<const EntityId> entities)
+		{
+			checkStructuralChange("destroyEntities");
+			std::vector<EntityId> unique;
+			unique.reserve(entities.size());
+			for (auto id : entities)
+				if (isValid(id))
+					unique.push_back(id);
+			std::sort(unique.begin(), unique.end());
+			unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+			implDestroyEntities(unique);
+		}
+
+		// terms are components or filters: view<Changed<const Transform>, Sprite>()
+		template <ConceptViewTerm... Ts>
 		auto view() noexcept -> ark::View<Ts...>;
 
-		template <ConceptComponent... Ts>
+		template <ConceptViewTerm... Ts>
 		operator ark::View<Ts...>() noexcept {
 			return this->view<Ts...>();
 		}
@@ -180,30 +464,40 @@ namespace ark {
 		*/
 		void* add(EntityId entityId, std::type_index type, EntityId toCopy = ArkInvalidID) {
 			addType(type);
-			return implRuntimeAdd(entityId, type, toCopy);
+			return implRuntimeAdd(entityId, idFromType(type), toCopy);
+		}
+
+		// same as above without hashing the type_index
+		void* add(EntityId entityId, const meta::Metadata& mdata, EntityId toCopy = ArkInvalidID) {
+			int compId = idFromType(mdata);
+			if (compId == ArkInvalidIndex) {
+				addType(mdata.type);
+				compId = idFromType(mdata);
+			}
+			return implRuntimeAdd(entityId, compId, toCopy);
 		}
 
 		/* copy-constructs from 'toClone' and calls the clone signal
 		*/ 
 		void* clone(EntityId entityId, std::type_index type, Entity toClone) {
 			void* ptr = add(entityId, type, toClone);
-			signalTable(m_tableClone, type, Entity{ entityId, this }, Entity{ toClone, this });
+			if (int compId = idFromType(type); compId != ArkInvalidIndex)
+				m_tableClone[compId].publish(Entity{ entityId, this }, Entity{ toClone, this });
 			return ptr;
 		}
 
+		// the runtime get marks the component as changed
 		void* get(EntityId entityId, std::type_index type) const
 		{
-			auto& entity = getEntity(entityId);
-			int compId = idFromType(type);
-#if !NDEBUG
-			if (compId == ArkInvalidID || !entity.mask.test(compId)) {
-				EngineLog(LogSource::EntityM, LogLevel::Warning, "entity (%d), doesn't have component (%s)", entityId, type.name());
-				return nullptr;
-			}
-#endif
-			return entity.components[compId].ptr;
+			return implRuntimeGet(entityId, idFromType(type), type, true);
+		}
+
+		void* get(EntityId entityId, const meta::Metadata& mdata) const
+		{
+			return implRuntimeGet(entityId, idFromType(mdata), mdata.type, true);
 		}
 
+		// get<T>/tryGet<T> mark the component as changed, get<const T>/tryGet<const T> don't
 		template <typename T>
 		T& get(EntityId entityId) const noexcept {
 			return *tryGet<T>(entityId);
@@ -211,17 +505,42 @@ namespace ark {
 
 		template <typename T>
 		T* tryGet(EntityId entityId) const noexcept {
-			return static_cast<T*>(m_entities[entityId].components[idFromType<T>()].ptr);
+			if constexpr (std::is_const_v<T>)
+				return static_cast<T*>(tryComponent(entityId, idFromType<T>()));
+			else
+				return static_cast<T*>(tryComponentChanged(entityId, idFromType<T>()));
 		}
 
+		/* marks the component as changed and calls fun(T&), returns false if the entity doesn't have it
+		 * registry.patch<Transform>(entity, [](auto& trans) { trans.move(1, 0); });
+		*/
+		template <ConceptComponent T, std::invocable<T&> F>
+		bool patch(EntityId entityId, F&& fun) {
+			T* component = tryGet<T>(entityId);
+			if (!component)
+				return false;
+			std::invoke(std::forward<F>(fun), *component);
+			return true;
+		}
+
+		// the tick stamped on the components added or accessed for writing from now on
+		auto changeTick() const noexcept -> ChangeTick {
+			return m_changeTick.load(std::memory_order_relaxed);
+		}
+
+		// starts a new tick and returns the one that ended, SystemManager calls it after every system update
+		auto advanceChangeTick() noexcept -> ChangeTick {
+			return m_changeTick.fetch_add(1, std::memory_order_relaxed);
+		}
 
 		template <typename... Ts>
 		bool has(EntityId entity) const noexcept {
-			return ((this->tryGet<Ts>(entity) != nullptr) && ...);
+			return ((this->tryGet<const Ts>(entity) != nullptr) && ...);
 		}
 
 		bool has(EntityId entity, std::type_index type) const {
-			return this->get(entity, type) != nullptr;
+			int compId = idFromType(type);
+			return compId != ArkInvalidIndex && mask(entity).test(compId);
 		}
 
 		bool has(EntityId entity, std::span<std::type_index> types) const {
@@ -239,21 +558,17 @@ namespace ark {
 
 		void remove(EntityId entityId, std::type_index type)
 		{
-			auto& entity = getEntity(entityId);
-			auto compId = idFromType(type);
-			if (entity.mask.test(compId)) {
-				signalTable(m_tableRemove, type, *this, Entity{ entityId, this });
-				m_signalRemove.publish(*this, Entity{ entityId, this }, type);
-				entity.mask.set(compId, false);
-				m_masks[entityId].set(compId, false);
-				destroyComponent(type, entity.components[compId].ptr);
-				entity.components[compId] = {};
-			}
+			implRuntimeRemove(entityId, idFromType(type), type);
+		}
+
+		void remove(EntityId entityId, const meta::Metadata& mdata)
+		{
+			implRuntimeRemove(entityId, idFromType(mdata), mdata.type);
 		}
 
 		auto mask(EntityId entityId) const -> ComponentMask
 		{
-			return getEntity(entityId).mask;
+			return m_masks.at(entityId);
 		}
 
 		auto each() -> ProxyEntitiesView;
@@ -261,7 +576,7 @@ namespace ark {
 
 		template <std::invocable<EntityId> F>
 		void each(F&& fun) {
-			for (int i = 0; i < m_entities.size(); i++) {
+			for (int i = 0; i < m_masks.size(); i++) {
 				if (this->isValid(i))
 					fun(i);
 			}
@@ -270,24 +585,12 @@ namespace ark {
 		template <std::invocable<RuntimeComponent> F>
 		void eachComponent(EntityId entityId, F&& fun)
 		{
-			auto& entity = getEntity(entityId);
-			for (int i = 0; i < entity.mask.size(); ++i)
-				if (entity.mask.test(i))
-					fun(entity.components[i]);
+			auto mask = m_masks.at(entityId);
+			for (int i = 0; i < mask.size(); ++i)
+				if (mask.test(i))
+					fun(RuntimeComponent{ typeFromId(i), component(entityId, i), m_metadata[i] });
 		}
 
-		//auto eachComponent(EntityId entity) {
-		//	return this->m_entities[entity].components
-		//		| std::views::filter([](const auto& compData) { return compData.ptr != nullptr; })
-		//		| std::views::transform([](auto& compData) {return RuntimeComponent(compData.type, compData.ptr); }); // poate nu am nevoie de asta
-		//}
-
-		//auto each() {
-		//	return this->m_entities
-		//		| std::views::filter([this](const auto& entityData) { return !this->m_isFree[entityData.id]; })
-		//		| std::views::transform([this](auto& data) { return ark::Entity(data.id, this); });
-		//}
-
 		template <typename... Ts>
 		void idFromType(ComponentMask& mask) const
 		{
@@ -302,14 +605,17 @@ namespace ark {
 
 		int idFromType(std::type_index type) const
 		{
-			auto ids = getTypes();
-			auto pos = std::find(ids.begin(), ids.end(), type);
-			if (pos == ids.end()) {
+			const auto* mdata = meta::resolve(type);
+			int compId = mdata ? idFromType(*mdata) : ArkInvalidIndex;
+			if (compId == ArkInvalidIndex)
 				EngineLog(LogSource::ComponentM, LogLevel::Warning, "type not found (%s) ", type.name());
-				return ArkInvalidIndex;
-			}
-			else 
-				return pos - ids.begin();
+			return compId;
+		}
+
+		// O(1), Metadata::index -> component id
+		int idFromType(const meta::Metadata& mdata) const noexcept
+		{
+			return mdata.index < m_idOfMeta.size() ? m_idOfMeta[mdata.index] : ArkInvalidIndex;
 		}
 
 		auto typeFromId(int id) const -> std::type_index {
@@ -327,7 +633,12 @@ namespace ark {
 				// TODO: add abort with grace
 				std::abort();
 			}
-			this->componentIds()[m_componentsNum++] = type;
+			registerComponentId(m_componentsNum++, type);
+		}
+
+		// nullptr if the component id isn't used yet
+		auto metadataFromId(int id) const -> const meta::Metadata* {
+			return m_metadata[id];
 		}
 
 		auto getTypes() const -> std::span<const std::type_index>
@@ -335,6 +646,11 @@ namespace ark {
 			return { componentIds().data(), static_cast<std::size_t>(m_componentsNum) };
 		}
 
+		auto storagePolicy() const -> StoragePolicy
+		{
+			return m_archetypes ? StoragePolicy::Archetype : StoragePolicy::SparseSet;
+		}
+
 #if 0 // disable entity children
 		void addChildTo(Entity p, Entity c)
 		{
@@ -411,46 +727,295 @@ namespace ark {
 
 	private:
 
-		void* allocateComponent(EntityId entityId, int compId, std::size_t size, std::size_t align, std::type_index type) {
-			auto& entity = getEntity(entityId);
-			entity.mask.set(compId);
-			m_masks[entityId].set(compId);
-			void* newComponent = m_componentPool->allocate(size, align);
-			entity.components[compId] = { type, newComponent };
-			return newComponent;
+		auto pool(int compId, std::type_index type) -> ComponentPool&
+		{
+			auto& pool = m_pools[compId];
+			if (!pool) {
+				if (!m_metadata[compId])
+					registerComponentId(compId, type);
+				pool = std::make_unique<ComponentPool>(*m_metadata[compId], m_componentResource);
+			}
+			return *pool;
+		}
+
+		void registerComponentId(int compId, std::type_index type)
+		{
+			componentIds()[compId] = type;
+			const auto* mdata = meta::resolve(type);
+			m_metadata[compId] = mdata;
+			if (!mdata)
+				return;
+			if (const auto* onAdd = mdata->data<OnAddService>(serviceOnAddName))
+				Sink{ m_tableAdd[compId] }.connect(*onAdd);
+			if (mdata->index >= m_idOfMeta.size())
+				m_idOfMeta.resize(mdata->index + 1, ArkInvalidIndex);
+			m_idOfMeta[mdata->index] = compId;
+		}
+
+		/* views in sparse mode iterate the pool with the fewest slots from 'mask' and test the mask of each candidate
+		 * the slots are compared, not the live components: the tombstones are iterated too
+		 * 'pool' is nullptr if 'mask' is empty, then every entity is a candidate
+		 * returns false if nothing can match (one of the components was never added)
+		*/
+		bool viewCandidates(ComponentMask mask, const ComponentPool*& pool) const noexcept {
+			pool = nullptr;
+			for (int compId = 0; compId < MaxComponentTypes; compId++) {
+				if (!mask.test(compId))
+					continue;
+				auto* candidate = m_pools[compId].get();
+				if (!candidate)
+					return false;
+				if (!pool || candidate->entities().size() < pool->entities().size())
+					pool = candidate;
+			}
+			return true;
+		}
+
+		bool viewMatches(EntityId entityId, const ViewMask& mask) const noexcept {
+			return entityId != ComponentPool::Tombstone && !m_isFree[entityId] && mask.matches(m_masks[entityId]);
+		}
+
+		// the entity must have every filtered component
+		bool viewPasses(EntityId entityId, const ViewFilters& filters) const noexcept {
+			for (int compId = 0; compId < MaxComponentTypes; compId++) {
+				if (filters.changed.test(compId) && !isNewer(componentTicks(entityId, compId).changed, filters.since))
+					return false;
+				if (filters.added.test(compId) && !isNewer(componentTicks(entityId, compId).added, filters.since))
+					return false;
+			}
+			return true;
+		}
+
+	public:
+		// View::par_each and the parallel SystemManager::update lock the structure: no entity/component can be created or destroyed until they end
+		struct StructureLock {
+			EntityManager* manager;
+			StructureLock(EntityManager* m) : manager(m) { manager->m_structureLocks++; }
+			~StructureLock() { manager->m_structureLocks--; }
+		};
+
+	private:
+		void checkStructuralChange(const char* operation) const {
+			if (m_structureLocks != 0) {
+				EngineLog(LogSource::EntityM, LogLevel::Error, 
+					"aborting... %s called during View::par_each or a parallel system update, structural changes are not allowed there", operation);
+				std::abort();
+			}
+		}
+
+		// returns uninitialized memory
+		void* allocateComponent(EntityId entityId, int compId, std::type_index type) {
+			checkStructuralChange("add component");
+			m_masks.at(entityId).set(compId);
+			if (m_archetypes) {
+				if (!m_metadata[compId])
+					registerComponentId(compId, type);
+				return m_archetypes->emplace(entityId, compId, *m_metadata[compId], changeTick());
+			}
+			return pool(compId, type).emplace(entityId, changeTick());
+		}
+
+		void eraseComponent(EntityId entityId, int compId) {
+			checkStructuralChange("remove component");
+			if (m_archetypes)
+				m_archetypes->erase(entityId, compId);
+			else
+				m_pools[compId]->erase(entityId);
+		}
+
+		void* tryComponent(EntityId entityId, int compId) const noexcept {
+			if (m_archetypes)
+				return m_archetypes->tryGet(entityId, compId);
+			auto& pool = m_pools[compId];
+			return pool ? pool->tryGet(entityId) : nullptr;
+		}
+
+		// like tryComponent, also marks the component as changed
+		void* tryComponentChanged(EntityId entityId, int compId) const noexcept {
+			if (m_archetypes)
+				return m_archetypes->tryGet(entityId, compId, changeTick());
+			auto& pool = m_pools[compId];
+			return pool ? pool->tryGet(entityId, changeTick()) : nullptr;
+		}
+
+		// the entity must have the component
+		void* component(EntityId entityId, int compId) const noexcept {
+			if (m_archetypes)
+				return m_archetypes->get(entityId, compId);
+			return m_pools[compId]->get(entityId);
+		}
+
+		// the entity must have the component
+		auto componentTicks(EntityId entityId, int compId) const noexcept -> const ComponentTicks& {
+			if (m_archetypes)
+				return m_archetypes->ticks(entityId, compId);
+			return m_pools[compId]->ticks(entityId);
+		}
+
+		auto allocateEntity() -> EntityId
+		{
+			EntityId id;
+			if (m_freeEntities.size() > 0) {
+				id = m_freeEntities.back();
+				m_freeEntities.pop_back();
+				m_isFree[id] = false;
+			} else {
+				id = m_masks.size();
+				m_isFree.push_back(false);
+				m_masks.emplace_back();
+			}
+			return id;
+		}
+
+		// 'memory' returns the uninitialized component of an entity
+		template <typename T, typename F>
+		void constructBulk(std::span<const EntityId> entities, F&& memory, const T& prototype)
+		{
+			const int compId = idFromType<T>();
+			for (auto id : entities)
+				std::construct_at(static_cast<T*>(memory(id, compId)), prototype);
+		}
+
+		void publishAddBulk(int compId, std::type_index type, std::span<const EntityId> entities)
+		{
+			if (m_tableAdd[compId].size())
+				for (auto id : entities)
+					m_tableAdd[compId].publish(*this, Entity{ id, this });
+			if (m_signalAdd.size())
+				for (auto id : entities)
+					m_signalAdd.publish(*this, Entity{ id, this }, type);
+			m_tableAddBatch[compId].publish(*this, entities);
+		}
+
+		// the entities must be valid and unique
+		void implDestroyEntities(std::span<const EntityId> entities)
+		{
+			if (entities.empty())
+				return;
+			m_signalDestroyBatch.publish(*this, entities);
+			if (m_signalDestroy.size())
+				for (auto id : entities)
+					m_signalDestroy.publish(*this, Entity{ id, this });
+
+			// semnalele de remove, tip cu tip, inainte sa distrugem ceva (ca la remove)
+			for (int compId = 0; compId < MaxComponentTypes; compId++) {
+				auto& perType = m_tableRemove[compId];
+				if (!perType.size() && !m_signalRemove.size())
+					continue;
+				auto type = typeFromId(compId);
+				for (auto id : entities) {
+					if (!m_masks[id].test(compId))
+						continue;
+					perType.publish(*this, Entity{ id, this });
+					m_signalRemove.publish(*this, Entity{ id, this }, type);
+				}
+			}
+
+			for (auto id : entities) {
+				if (m_archetypes)
+					m_archetypes->destroy(id);
+				else {
+					auto mask = m_masks[id];
+					for (int compId = 0; compId < MaxComponentTypes; compId++)
+						if (mask.test(compId))
+							m_pools[compId]->erase(id);
+				}
+				m_masks[id].reset();
+				m_isFree[id] = true;
+				m_freeEntities.push_back(id);
+			}
 		}
 
 		template <typename T, typename... Args>
 		T& implStaticAdd(EntityId entityId, Args&&... args) {
 			int compId = idFromType<T>();
-			auto& entity = getEntity(entityId);
-			if (entity.mask[compId])
-				return *static_cast<T*>(entity.components[compId].ptr);
+			if (m_masks.at(entityId).test(compId))
+				return *static_cast<T*>(component(entityId, compId));
 
-			void* newComponent = allocateComponent(entityId, compId, sizeof(T), alignof(T), typeid(T));
+			void* newComponent = allocateComponent(entityId, compId, typeid(T));
 			std::construct_at<T>((T*)newComponent, std::forward<Args>(args)...);
 
-			signalTable(m_tableAdd, typeid(T), *this, Entity{ entityId, this });
+			m_tableAdd[compId].publish(*this, Entity{ entityId, this });
 			m_signalAdd.publish(*this, Entity{ entityId, this }, typeid(T));
 			return *static_cast<T*>(newComponent);
 		}
 
-		void* implRuntimeAdd(EntityId entityId, std::type_index type, EntityId toClone)
+		void* implRuntimeGet(EntityId entityId, int compId, std::type_index type, bool markChanged = false) const
 		{
-			int compId = idFromType(type);
-			auto& entity = getEntity(entityId);
-			if (entity.mask.test(compId))
-				return entity.components[compId].ptr;
+#if !NDEBUG
+			if (compId == ArkInvalidID || !m_masks.at(entityId).test(compId)) {
+				EngineLog(LogSource::EntityM, LogLevel::Warning, "entity (%d), doesn't have component (%s)", entityId, type.name());
+				return nullptr;
+			}
+#endif
+			return markChanged ? tryComponentChanged(entityId, compId) : tryComponent(entityId, compId);
+		}
+
+		void implRuntimeRemove(EntityId entityId, int compId, std::type_index type)
+		{
+			if (compId != ArkInvalidIndex && m_masks.at(entityId).test(compId)) {
+				m_tableRemove[compId].publish(*this, Entity{ entityId, this });
+				m_signalRemove.publish(*this, Entity{ entityId, this }, type);
+				m_masks[entityId].set(compId, false);
+				eraseComponent(entityId, compId);
+			}
+		}
+
+		/* moves sources[i] in the new component of entities[i], used by CommandBuffer::playback for every component type
+		 * the entities must be valid, unique and without the component; storage is reserved once,
+		 * the signals are published after every entity got its component, like createEntities
+		*/
+		void implRelocateAddBatch(int compId, std::type_index type, std::span<const EntityId> entities,
+			std::span<void* const> sources, void (*relocate)(void*, void*))
+		{
+			checkStructuralChange("add component");
+			if (entities.empty())
+				return;
+			if (m_archetypes) {
+				if (!m_metadata[compId])
+					registerComponentId(compId, type);
+				m_archetypes->setMetadata(compId, *m_metadata[compId]);
+				// the entities that had the same components move to the same archetype
+				std::vector<std::pair<ComponentMask, std::size_t>> targets;
+				for (auto id : entities) {
+					auto mask = ComponentMask{ m_masks[id] }.set(compId);
+					auto it = std::find_if(targets.begin(), targets.end(), [&](const auto& target) { return target.first == mask; });
+					if (it == targets.end())
+						targets.emplace_back(mask, 1);
+					else
+						it->second++;
+				}
+				for (const auto& [mask, count] : targets)
+					m_archetypes->reserve(mask, count);
+			}
+			else
+				pool(compId, type).reserve(entities.size(), *std::max_element(entities.begin(), entities.end()));
+
+			const auto tick = changeTick();
+			for (std::size_t i = 0; i < entities.size(); i++) {
+				const auto id = entities[i];
+				m_masks[id].set(compId);
+				void* component = m_archetypes ? m_archetypes->emplace(id, compId, *m_metadata[compId], tick) : m_pools[compId]->emplace(id, tick);
+				relocate(component, sources[i]);
+			}
+			publishAddBulk(compId, type, entities);
+		}
 
-			auto metadata = meta::resolve(type);
-			void* newComponent = allocateComponent(entityId, compId, metadata->size, metadata->align, type);
+		void* implRuntimeAdd(EntityId entityId, int compId, EntityId toClone)
+		{
+			if (m_masks.at(entityId).test(compId))
+				return component(entityId, compId);
 
-			const void* compToClone = isValid(toClone) ? get(toClone, type) : nullptr;
+			auto type = typeFromId(compId);
+			void* newComponent = allocateComponent(entityId, compId, type);
+			auto metadata = m_metadata[compId];
+
+			const void* compToClone = isValid(toClone) ? implRuntimeGet(toClone, compId, type) : nullptr;
 			if(compToClone && metadata->copy_constructor)
 				metadata->copy_constructor(newComponent, compToClone);
 			else
 				metadata->default_constructor(newComponent);
-			signalTable(m_tableAdd, type, *this, Entity{ entityId, this });
+			m_tableAdd[compId].publish(*this, Entity{ entityId, this });
 			m_signalAdd.publish(*this, Entity{ entityId, this }, type);
 			return newComponent;
 		}
@@ -465,46 +1030,19 @@ namespace ark {
 			return *reinterpret_cast<compIds_t*>(&m_storageCompIDs);
 		}
 
-		void destroyComponent(std::type_index type, void* component)
-		{
-			auto metadata = meta::resolve(type);
-			if(metadata->destructor)
-				metadata->destructor(component);
-			m_componentPool->deallocate(component, metadata->size, metadata->align);
-		}
-
-		template <typename Table, typename... Args>
-		void signalTable(Table& table, std::type_index type, Args&&... args) {
-			if (auto it = table.find(type); it != table.end()) {
-				auto& func = it->second;
-				func.publish(std::forward<Args>(args)...);
-			}
-		}
-
-		struct InternalEntityData {
-			ComponentMask mask;
-			int id = ArkInvalidID;
-			std::array<RuntimeComponent, MaxComponentTypes> components;
-		};
-
-		auto getEntity(EntityId id) -> InternalEntityData&
-		{
-			return m_entities.at(id);
-		}
-		auto getEntity(EntityId id) const -> const InternalEntityData&
-		{
-			return m_entities.at(id);
-		}
-
-		using ComponentVector = decltype(InternalEntityData::components);
-
 	private:
 		using storageCompIds_t = std::aligned_storage_t<sizeof(compIds_t), alignof(compIds_t)>;
 		int m_componentsNum = 0;
 		storageCompIds_t m_storageCompIDs;
-		std::unique_ptr<std::pmr::unsynchronized_pool_resource> m_componentPool;
-		std::vector<InternalEntityData> m_entities;
-		std::vector<ComponentMask> m_masks; // used by View
+		// paginile din pool-uri si chunk-urile din archetypes sunt toate mai mari decat blocurile unui pool_resource, merg direct aici
+		std::pmr::memory_resource* m_componentResource;
+		std::array<std::unique_ptr<ComponentPool>, MaxComponentTypes> m_pools; // index = component id, creat la primul add
+		std::unique_ptr<ArchetypeManager> m_archetypes; // nullptr daca policy-ul e SparseSet
+		std::array<const meta::Metadata*, MaxComponentTypes> m_metadata{}; // index = component id
+		std::vector<int> m_idOfMeta; // Metadata::index -> component id, pentru idFromType(type_index) in O(1)
+		std::atomic<int> m_structureLocks = 0; // > 0 in timpul unui View::par_each sau al unui update paralel din SystemManager
+		std::atomic<ChangeTick> m_changeTick = 1; // 0 e 'niciodata', sistemele pornesc cu lastRunTick = 0
+		std::vector<ComponentMask> m_masks; // index = entity id, used by View
 		std::vector<Entity::ID> m_freeEntities; // as putea folosi un implicit list (int m_nextFree;) vezi entt: you dont have to store free entitites sau ceva de genu
 		int m_nextFree = ArkInvalidIndex;
 		std::vector<bool> m_isFree; // pentru verificate rapida
@@ -513,19 +1051,26 @@ namespace ark {
 		Signal<void(EntityManager&, Entity)> m_signalDestroy;
 		Signal<void(EntityManager&, Entity, std::type_index)> m_signalAdd; // any comp. add, type_index is type of component added
 		Signal<void(EntityManager&, Entity, std::type_index)> m_signalRemove; // analog
+		Signal<void(EntityManager&, std::span<const EntityId>)> m_signalCreateBatch;
+		Signal<void(EntityManager&, std::span<const EntityId>)> m_signalDestroyBatch;
+		Signal<void(EntityManager&)> m_signalCompact;
 
+		// index = component id
 		template <typename F>
-		using SignalTable = std::unordered_map<std::type_index, Signal<F>>;
+		using SignalTable = std::array<Signal<F>, MaxComponentTypes>;
 
 		SignalTable<void(EntityManager&, Entity)> m_tableAdd;
 		SignalTable<void(EntityManager&, Entity)> m_tableRemove;
 		SignalTable<void(Entity, Entity)> m_tableClone;
+		SignalTable<void(EntityManager&, std::span<const EntityId>)> m_tableAddBatch;
+		SignalTable<void(EntityManager&, std::span<const EntityId>, Entity)> m_tableCloneBatch;
 
 		friend struct ProxyRuntimeComponentIterator;
 		friend struct ProxyEntityIterator;
 		friend class ProxyRuntimeComponentView;
 		friend class ProxyEntitiesView;
 		friend class Entity;
+		friend class CommandBuffer;
 		template <typename...> friend class View;
 		template <bool, typename...> friend class IteratorView;
 		template <bool, typename...> friend class ProxyView;
@@ -533,28 +1078,143 @@ namespace ark {
 	};
 
 
+	namespace detail {
+		// what term T gives for one entity, see view_term_yield_t; a non-const component is marked as changed
+		template <typename T>
+		auto viewTerm(EntityManager& manager, EntityId entity) noexcept -> view_term_yield_t<T>
+		{
+			using C = view_component_t<T>;
+			if constexpr (view_term_kind_v<T> == ViewTermKind::Excluded)
+				return {};
+			else if constexpr (view_term_kind_v<T> == ViewTermKind::Optional)
+				return view_term_yield_t<T>{ manager.tryGet<C>(entity) };
+			else
+				return view_term_yield_t<T>{ manager.get<C>(entity) };
+		}
+
+		/* the columns of the terms 'Ts' in one archetype chunk, getting a non-const component marks it as changed
+		 * a Maybe<T> column is nullptr in the archetypes without T, Without<T> has no column
+		*/
+		template <typename... Ts>
+		struct ChunkColumns {
+			template <std::size_t I>
+			using Term = std::tuple_element_t<I, std::tuple<Ts...>>;
+
+			std::tuple<std::remove_const_t<view_component_t<Ts>>*...> components{};
+			std::array<ComponentTicks*, sizeof...(Ts)> ticks{};
+
+			void load(const EntityManager& manager, const ArchetypeManager::Archetype& arch, std::size_t chunk) noexcept
+			{
+				[&]<std::size_t... Is>(std::index_sequence<Is...>) {
+					(loadColumn<Is>(manager, arch, chunk), ...);
+				}(std::index_sequence_for<Ts...>{});
+			}
+
+			template <std::size_t I>
+			auto get(std::size_t row, ChangeTick tick) noexcept -> view_term_yield_t<Term<I>>
+			{
+				constexpr auto kind = view_term_kind_v<Term<I>>;
+				if constexpr (kind == ViewTermKind::Excluded)
+					return {};
+				else {
+					auto* column = std::get<I>(components);
+					if constexpr (kind == ViewTermKind::Optional)
+						if (!column)
+							return view_term_yield_t<Term<I>>{ nullptr };
+					if constexpr (!std::is_const_v<view_component_t<Term<I>>>)
+						ticks[I][row].changed = tick;
+					if constexpr (kind == ViewTermKind::Optional)
+						return view_term_yield_t<Term<I>>{ column + row };
+					else
+						return view_term_yield_t<Term<I>>{ column[row] };
+				}
+			}
+
+			// every term of 'row' concatenated, see view_yield_t
+			auto values(std::size_t row, ChangeTick tick) noexcept -> view_yield_t<Ts...>
+			{
+				return [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+					return std::tuple_cat(get<Is>(row, tick)...);
+				}(std::index_sequence_for<Ts...>{});
+			}
+
+			// fun(values...)
+			template <typename F>
+			decltype(auto) apply(std::size_t row, ChangeTick tick, F&& fun) noexcept
+			{
+				return std::apply(std::forward<F>(fun), values(row, tick));
+			}
+
+		private:
+			template <std::size_t I>
+			void loadColumn(const EntityManager& manager, const ArchetypeManager::Archetype& arch, std::size_t chunk) noexcept
+			{
+				using C = std::remove_const_t<view_component_t<Term<I>>>;
+				if constexpr (view_term_kind_v<Term<I>> != ViewTermKind::Excluded) {
+					int column = arch.columnOf[manager.idFromType<C>()];
+					std::get<I>(components) = column == ArkInvalidIndex ? nullptr : static_cast<C*>(static_cast<void*>(arch.column(chunk, column)));
+					ticks[I] = column == ArkInvalidIndex ? nullptr : arch.ticks(chunk, column);
+				}
+			}
+		};
+	}
+
 	template <bool bRetEnt=false, typename... Cs>
 	class IteratorView {
-		using Iter = decltype(EntityManager::m_entities)::iterator;
 		using Self = IteratorView;
+		using Archetype = ArchetypeManager::Archetype;
+		using Yield = view_yield_t<Cs...>;
 		EntityManager* m_manager;
-		ComponentMask m_mask;
-		Iter m_iter;
-		decltype(EntityManager::m_masks)::iterator m_iterMask;
+		ViewMask m_mask;
+		ViewFilters m_filters;
+		ChangeTick m_tick; // stamped on the non-const components
+		EntityId m_id;
+		// folosite doar cu StoragePolicy::SparseSet, m_index e in pool-ul cel mai mic (sau in toate entitatile daca m_pool e nullptr)
+		const ComponentPool* m_pool = nullptr;
+		std::size_t m_index = 0;
+		std::size_t m_end = 0;
+		// folosite doar cu StoragePolicy::Archetype
+		int m_arch = 0;
+		std::size_t m_chunk = 0;
+		std::size_t m_row = 0;
+		std::size_t m_rows = 0;
+		detail::ChunkColumns<Cs...> m_columns;
+		ViewFilters::Chunk m_chunkFilter;
 	public:
 
-		IteratorView(Iter iter, ComponentMask mask, EntityManager* man)
-			: m_iter(iter), m_mask(mask), m_manager(man)
+		IteratorView(bool atEnd, const ViewMask& mask, const ViewFilters& filters, EntityManager* man)
+			: m_mask(mask), m_filters(filters), m_manager(man), m_tick(man->changeTick())
 		{
-			m_iterMask = m_manager->m_masks.begin();
-			if (m_iter != m_manager->m_entities.end() && (*m_iterMask & m_mask) != m_mask)
-				this->operator++();
+			if (m_manager->m_archetypes) {
+				m_id = ArkInvalidID;
+				if (atEnd)
+					m_arch = static_cast<int>(archetypes().size());
+				else {
+					seekArchetype();
+					if (m_arch < archetypes().size() && !rowPasses())
+						this->operator++();
+				}
+			}
+			else {
+				if (m_manager->viewCandidates(m_mask.include, m_pool))
+					m_end = m_pool ? m_pool->entities().size() : m_manager->m_masks.size();
+				m_index = atEnd ? m_end : 0;
+				m_id = ArkInvalidID;
+				if (m_index < m_end && !matches())
+					this->operator++();
+			}
 		}
 
 		auto operator++() noexcept {
-			++m_iter;
-			while (m_iter < m_manager->m_entities.end() && (*(++m_iterMask) & m_mask) != m_mask) {
-				++m_iter;
+			if (m_manager->m_archetypes) {
+				do {
+					nextRow();
+				} while (m_arch < archetypes().size() && !rowPasses());
+				return *this;
+			}
+			++m_index;
+			while (m_index < m_end && !matches()) {
+				++m_index;
 			}
 			return *this;
 		}
@@ -562,53 +1222,110 @@ namespace ark {
 		[[nodiscard]]
 		decltype(auto) operator*() noexcept {
 
-			if constexpr (sizeof...(Cs) == 0) {
-				return ark::Entity{ m_iter->id, m_manager };
+			if constexpr (std::tuple_size_v<Yield> == 0) {
+				return ark::Entity{ m_id, m_manager };
 			}
 			else if constexpr (bRetEnt) {
-				auto entity = ark::Entity{ m_iter->id, m_manager };
-				return std::tuple<ark::Entity, Cs&...>(entity, m_manager->get<Cs>(m_iter->id)...);
+				return std::tuple_cat(std::tuple<ark::Entity>(ark::Entity{ m_id, m_manager }), values());
 			}
 			else {
-				if constexpr (sizeof...(Cs) == 1)
-					return (m_manager->get<Cs>(m_iter->id), ...);
+				if constexpr (std::tuple_size_v<Yield> == 1)
+					return static_cast<std::tuple_element_t<0, Yield>>(std::get<0>(values()));
 				else
-					return std::tuple<Cs&...>(m_manager->get<Cs>(m_iter->id)...);
+					return values();
 			}
 		}
 
 		friend bool operator==(const Self& a, const Self& b) noexcept
 		{
-			return a.m_iter == b.m_iter;
+			return a.m_index == b.m_index && a.m_arch == b.m_arch && a.m_chunk == b.m_chunk && a.m_row == b.m_row;
 		}
 
 		friend bool operator!=(const Self& a, const Self& b) noexcept
 		{
-			return a.m_iter != b.m_iter;
+			return !(a == b);
+		}
+
+	private:
+		// also sets m_id
+		bool matches() noexcept {
+			m_id = m_pool ? m_pool->entities()[m_index] : static_cast<EntityId>(m_index);
+			return m_manager->viewMatches(m_id, m_mask) && (m_filters.empty() || m_manager->viewPasses(m_id, m_filters));
+		}
+
+		bool rowPasses() const noexcept {
+			return m_filters.empty() || m_chunkFilter.passes(m_row);
+		}
+
+		auto values() noexcept -> Yield {
+			if (m_manager->m_archetypes)
+				return m_columns.values(m_row, m_tick);
+			return std::tuple_cat(detail::viewTerm<Cs>(*m_manager, m_id)...);
+		}
+
+		auto archetypes() const noexcept -> std::span<const Archetype> {
+			return m_manager->m_archetypes->archetypes();
+		}
+
+		// next row of the matching archetypes, without checking the filters
+		void nextRow() noexcept {
+			if (++m_row == m_rows) {
+				m_row = 0;
+				if (++m_chunk == archetypes()[m_arch].usedChunks()) {
+					m_chunk = 0;
+					++m_arch;
+					seekArchetype();
+					return;
+				}
+				loadChunk();
+			}
+			m_id = archetypes()[m_arch].entities(m_chunk)[m_row];
+		}
+
+		// advances m_arch to the first non-empty matching archetype, starting with the current one
+		void seekArchetype() noexcept {
+			auto archs = archetypes();
+			while (m_arch < archs.size() && (archs[m_arch].size == 0 || !m_mask.matches(archs[m_arch].mask)))
+				++m_arch;
+			if (m_arch < archs.size()) {
+				loadChunk();
+				m_id = archs[m_arch].entities(m_chunk)[m_row];
+			}
+			else
+				m_id = ArkInvalidID;
+		}
+
+		void loadChunk() noexcept {
+			auto& arch = archetypes()[m_arch];
+			m_rows = arch.rows(m_chunk);
+			m_columns.load(*m_manager, arch, m_chunk);
+			if (!m_filters.empty())
+				m_chunkFilter = m_filters.chunk(arch, m_chunk);
 		}
 	};
 
 	template <bool bRetEnt, typename... Cs>
 	class ProxyView {
 		EntityManager* m_manager;
-		ComponentMask m_mask;
+		ViewMask m_mask;
+		ViewFilters m_filters;
 
 	public:
-		ProxyView(ComponentMask mask, EntityManager* man) 
-			: m_mask(mask), m_manager(man) { }
+		ProxyView(const ViewMask& mask, const ViewFilters& filters, EntityManager* man)
+			: m_mask(mask), m_filters(filters), m_manager(man) { }
 
 		auto begin() {
-			return IteratorView<bRetEnt, Cs...>(m_manager->m_entities.begin(), m_mask, m_manager);
+			return IteratorView<bRetEnt, Cs...>(false, m_mask, m_filters, m_manager);
 		}
 		auto end() {
-			return IteratorView<bRetEnt, Cs...>(m_manager->m_entities.end(), m_mask, m_manager);
+			return IteratorView<bRetEnt, Cs...>(true, m_mask, m_filters, m_manager);
 		}
 	};
 
 	/*
 	* Folosire:
 	* auto view = manager.view<Comp1, ...>();
-	* 
+	*
 	* for(auto [c1, ...] : view)
 	* for(auto [ent, c1, ...] : view.each())
 	*
@@ -616,32 +1333,46 @@ namespace ark {
 	* for(auto [c1, ...] : view.each<C1...>()
 	* for(auto [ent, c1, ...] : view.each<Entity, C1...>())
 	* for(auto ent : view.each<Entity>())
+	*
+	* filtre: View<Changed<const Transform>, Sprite> da doar entitatile cu Transform-ul modificat dupa setSince(tick),
+	* custom args pastreaza filtrele view-ului
+	*
+	* View<Sprite, Without<Hidden>, Maybe<Outline>>: fara entitatile cu Hidden, Outline* e nullptr daca lipseste
+	* for(auto [sprite, outline] : view)
 	*/
 	template <typename... Cs>
 	class View {
-		ComponentMask m_mask;
+		ViewMask m_mask;
+		ViewFilters m_filters;
+		const ChangeTick* m_since = nullptr;
 		EntityManager* m_manager = nullptr;
 	public:
 
 		View() = default;
 
-		View(EntityManager& man) : m_manager(&man) { 
-			m_manager->idFromType<Cs...>(m_mask);
+		View(EntityManager& man) : m_manager(&man) {
+			(addTerm<Cs>(), ...);
 		}
 
+		/* Changed/Added terms yield the components changed/added after 'tick' (0 means since the manager was created)
+		 * the pointer version reads the tick at every iteration, System::declareView uses the system's last update
+		*/
+		void setSince(ChangeTick tick) { m_filters.since = tick; m_since = nullptr; }
+		void setSince(const ChangeTick* tick) { m_since = tick; }
+
 		auto begin() noexcept {
-			return IteratorView<false, Cs...>(m_manager->m_entities.begin(), m_mask, m_manager);
+			return IteratorView<false, Cs...>(false, m_mask, filters(), m_manager);
 		}
 		auto end() noexcept {
-			return IteratorView<false, Cs...>(m_manager->m_entities.end(), m_mask, m_manager);
+			return IteratorView<false, Cs...>(true, m_mask, filters(), m_manager);
 		}
 
 		auto each() {
-			return ProxyView<true, Cs...>(m_mask, m_manager);
+			return ProxyView<true, Cs...>(m_mask, filters(), m_manager);
 		}
 
 		//auto filter_view() {
-		//	return m_manager->entities 
+		//	return m_manager->entities
 		//		| std::views::filter([this](const auto& entity) { return (entity.mask & this->m_mask) == this->m_mask; });
 		//}
 
@@ -654,15 +1385,15 @@ namespace ark {
 		template <std::same_as<ark::Entity> TEntity, ConceptComponent...  Ts>
 		auto each() {
 			if constexpr (sizeof...(Ts) == 0)
-				return ProxyView<true>(m_mask, m_manager);
+				return ProxyView<true>(m_mask, filters(), m_manager);
 			else
-				return ProxyView<true, Ts...>(m_mask, m_manager);
+				return ProxyView<true, Ts...>(m_mask, filters(), m_manager);
 		}
 
 		template <ConceptComponent T, ConceptComponent... Ts>
 		requires (!std::same_as<ark::Entity, T>)
 		auto each() {
-			return ProxyView<false, T, Ts...>(m_mask, m_manager);
+			return ProxyView<false, T, Ts...>(m_mask, filters(), m_manager);
 		}
 
 		template <ConceptComponent... Ts>
@@ -671,144 +1402,256 @@ namespace ark {
 				return ((m_manager->get<Ts>(entity)), ...);
 			else if constexpr (sizeof...(Ts) > 1)
 				return std::tuple<Ts&...>(m_manager->get<Ts>(entity)...);
-			else if constexpr (sizeof...(Cs) == 1)
-				return ((m_manager->get<Cs>(entity)), ...);
-			else
-				return std::tuple<Cs&...>(m_manager->get<Cs>(entity)...);
+			else {
+				auto values = std::tuple_cat(detail::viewTerm<Cs>(*m_manager, entity)...);
+				if constexpr (std::tuple_size_v<decltype(values)> == 1)
+					return static_cast<std::tuple_element_t<0, decltype(values)>>(std::get<0>(values));
+				else
+					return values;
+			}
 		}
 
 		// daca 'fun' returneaza un bool atunci: true-continue/ false-break
+		// cu StoragePolicy::Archetype nu adauga/sterge componente in 'fun', randurile se muta
 		template <typename F>
 		void each(F&& fun) noexcept {
-			int index = 0;
-			for (auto& data : m_manager->m_entities) {
-				if (!m_manager->m_isFree[index] && (data.mask & m_mask) == m_mask) {
-					auto entity = ark::Entity{ data.id, m_manager };
-
-					if constexpr (std::invocable<F, ark::Entity>) {
-						if constexpr (not std::convertible_to<decltype(fun(entity)), bool>)
-							fun(entity);
-						else
-							if (!fun(entity))
-								break;
+			const auto filters = this->filters();
+			const auto tick = m_manager->changeTick();
+			if (m_manager->m_archetypes) {
+				detail::ChunkColumns<Cs...> columns;
+				ViewFilters::Chunk chunkFilter;
+				for (auto& arch : m_manager->m_archetypes->archetypes()) {
+					if (arch.size == 0 || !m_mask.matches(arch.mask))
+						continue;
+					for (std::size_t chunk = 0; chunk < arch.usedChunks(); chunk++) {
+						const EntityId* entities = arch.entities(chunk);
+						columns.load(*m_manager, arch, chunk);
+						if (!filters.empty())
+							chunkFilter = filters.chunk(arch, chunk);
+						for (std::size_t row = 0, rows = arch.rows(chunk); row < rows; row++) {
+							if (!filters.empty() && !chunkFilter.passes(row))
+								continue;
+							if (!columns.apply(row, tick, [&](auto&&... comps) { return invoke(fun, ark::Entity{ entities[row], m_manager }, comps...); }))
+								return;
+						}
 					}
-					else if constexpr (std::invocable<F, ark::Entity, Cs&...>) {
-						if constexpr (not std::convertible_to<decltype(fun(entity, m_manager->get<Cs>(entity)...)), bool>)
-							fun(entity, m_manager->get<Cs>(entity)...);
-						else
-							if (!fun(entity, m_manager->get<Cs>(entity)...))
-								break;
+				}
+				return;
+			}
+
+			const ComponentPool* pool;
+			if (!m_manager->viewCandidates(m_mask.include, pool))
+				return;
+			const std::size_t size = pool ? pool->entities().size() : m_manager->m_masks.size();
+			for (std::size_t index = 0; index < size; index++) {
+				EntityId id = pool ? pool->entities()[index] : static_cast<EntityId>(index);
+				if (m_manager->viewMatches(id, m_mask) && (filters.empty() || m_manager->viewPasses(id, filters))) {
+					auto entity = ark::Entity{ id, m_manager };
+					if (!std::apply([&](auto&&... comps) { return invoke(fun, entity, comps...); }, std::tuple_cat(detail::viewTerm<Cs>(*m_manager, id)...)))
+						break;
+				}
+			}
+		}
+
+		/* same callbacks as each(F), but entities are split in ranges of 'grain' and run on JobSystem::global()
+		 * 'fun' is called concurrently: it may modify the components it receives, but no entity/component
+		 * can be created or destroyed until the loop ends (the manager aborts if you try)
+		 * the return value of 'fun' is ignored, there is no early break; par_each can't be nested
+		 * with StoragePolicy::Archetype a job is a whole chunk and 'grain' is ignored
+		*/
+		template <typename F>
+		void par_each(F&& fun, std::size_t grain = 128) {
+			EntityManager::StructureLock lock{ m_manager };
+			auto& jobs = JobSystem::global();
+			const auto filters = this->filters();
+			const auto tick = m_manager->changeTick();
+
+			if (m_manager->m_archetypes) {
+				std::vector<std::pair<const ArchetypeManager::Archetype*, std::size_t>> chunks;
+				for (auto& arch : m_manager->m_archetypes->archetypes())
+					if (arch.size != 0 && m_mask.matches(arch.mask))
+						for (std::size_t chunk = 0; chunk < arch.usedChunks(); chunk++)
+							chunks.emplace_back(&arch, chunk);
+
+				jobs.parallelFor(chunks.size(), 1, [&](std::size_t begin, std::size_t end) {
+					detail::ChunkColumns<Cs...> columns;
+					ViewFilters::Chunk chunkFilter;
+					for (std::size_t i = begin; i < end; i++) {
+						auto& [arch, chunk] = chunks[i];
+						const EntityId* entities = arch->entities(chunk);
+						columns.load(*m_manager, *arch, chunk);
+						if (!filters.empty())
+							chunkFilter = filters.chunk(*arch, chunk);
+						for (std::size_t row = 0, rows = arch->rows(chunk); row < rows; row++)
+							if (filters.empty() || chunkFilter.passes(row))
+								columns.apply(row, tick, [&](auto&&... comps) { return invoke(fun, ark::Entity{ entities[row], m_manager }, comps...); });
 					}
-					else if constexpr (std::invocable<F, Cs&...>) {
-						if constexpr (not std::convertible_to<decltype(fun(m_manager->get<Cs>(entity)...)), bool>)
-							fun(m_manager->get<Cs>(entity)...);
-						else
-							if (!fun(m_manager->get<Cs>(entity)...))
-								break;
+				});
+				return;
+			}
+
+			const ComponentPool* pool;
+			if (!m_manager->viewCandidates(m_mask.include, pool))
+				return;
+			const std::size_t size = pool ? pool->entities().size() : m_manager->m_masks.size();
+			jobs.parallelFor(size, grain, [&](std::size_t begin, std::size_t end) {
+				for (std::size_t index = begin; index < end; index++) {
+					EntityId id = pool ? pool->entities()[index] : static_cast<EntityId>(index);
+					if (m_manager->viewMatches(id, m_mask) && (filters.empty() || m_manager->viewPasses(id, filters))) {
+						auto entity = ark::Entity{ id, m_manager };
+						std::apply([&](auto&&... comps) { return invoke(fun, entity, comps...); }, std::tuple_cat(detail::viewTerm<Cs>(*m_manager, id)...));
 					}
-					else
-						static_assert(std::invocable<F, ark::Entity>, "View.each error: callback-ul are argumnete gresite");
 				}
-				index++;
+			});
+		}
+
+	private:
+		template <typename C>
+		void addTerm() {
+			const int compId = m_manager->idFromType<view_component_t<C>>();
+			if constexpr (view_term_kind_v<C> == ViewTermKind::Required)
+				m_mask.include.set(compId);
+			else if constexpr (view_term_kind_v<C> == ViewTermKind::Excluded)
+				m_mask.exclude.set(compId);
+
+			constexpr auto filter = detail::view_term<C>::filter;
+			if constexpr (filter == ViewFilter::Changed)
+				m_filters.changed.set(compId);
+			else if constexpr (filter == ViewFilter::Added)
+				m_filters.added.set(compId);
+		}
+
+		auto filters() const noexcept -> ViewFilters {
+			auto filters = m_filters;
+			if (m_since)
+				filters.since = *m_since;
+			return filters;
+		}
+
+		// returns false if the loop should stop
+		// 'comps' are the values of the terms, see view_yield_t
+		template <typename F, typename... Args>
+		static bool invoke(F& fun, ark::Entity entity, Args&... comps) {
+			if constexpr (std::invocable<F, ark::Entity>) {
+				if constexpr (not std::convertible_to<decltype(fun(entity)), bool>)
+					fun(entity);
+				else
+					return fun(entity);
 			}
+			else if constexpr (std::invocable<F, ark::Entity, Args&...>) {
+				if constexpr (not std::convertible_to<decltype(fun(entity, comps...)), bool>)
+					fun(entity, comps...);
+				else
+					return fun(entity, comps...);
+			}
+			else if constexpr (std::invocable<F, Args&...>) {
+				if constexpr (not std::convertible_to<decltype(fun(comps...)), bool>)
+					fun(comps...);
+				else
+					return fun(comps...);
+			}
+			else
+				static_assert(std::invocable<F, ark::Entity>, "View.each error: callback-ul are argumnete gresite");
+			return true;
 		}
 	};
 
-	template <ConceptComponent... Ts>
+	template <ConceptViewTerm... Ts>
 	inline auto EntityManager::view() noexcept -> ark::View<Ts...> {
 		return View<Ts...>(*this);
 	}
 
 	struct ProxyRuntimeComponentIterator {
-		using InternalIterator = decltype(EntityManager::InternalEntityData::components)::iterator;
-		InternalIterator m_iter;
-		InternalIterator m_end;
+		EntityManager* m_manager;
+		EntityId m_entity;
+		ComponentMask m_mask;
+		int m_compId;
 	public:
 		auto& operator++()
 		{
-			++m_iter;
-			while (m_iter < m_end && !m_iter->ptr)
-				++m_iter;
+			++m_compId;
+			while (m_compId < MaxComponentTypes && !m_mask.test(m_compId))
+				++m_compId;
 			return *this;
 		}
 
-		ProxyRuntimeComponentIterator(decltype(m_iter) iter, decltype(m_end) mEnd) :m_iter(iter), m_end(mEnd) { 
-			if (m_iter != m_end && !m_iter->ptr)
+		ProxyRuntimeComponentIterator(EntityManager* manager, EntityId entity, int compId)
+			: m_manager(manager), m_entity(entity), m_mask(manager->mask(entity)), m_compId(compId) { 
+			if (m_compId < MaxComponentTypes && !m_mask.test(m_compId))
 				++(*this);
 		}
 
-
 		RuntimeComponent operator*()
 		{
-			return *m_iter;
+			return { m_manager->typeFromId(m_compId), m_manager->component(m_entity, m_compId), m_manager->m_metadata[m_compId] };
 		}
 
 		friend bool operator==(const ProxyRuntimeComponentIterator& a, const ProxyRuntimeComponentIterator& b) noexcept
 		{
-			return a.m_iter == b.m_iter;
+			return a.m_compId == b.m_compId;
 		}
 
 		friend bool operator!=(const ProxyRuntimeComponentIterator& a, const ProxyRuntimeComponentIterator& b) noexcept
 		{
-			return a.m_iter != b.m_iter;
+			return a.m_compId != b.m_compId;
 		}
 	};
 
 	class ProxyRuntimeComponentView {
-		EntityManager::InternalEntityData& m_data;
+		EntityManager* m_manager;
+		EntityId m_entity;
 	public:
-		ProxyRuntimeComponentView(decltype(m_data) data) : m_data(data) {}
-		auto begin() -> ProxyRuntimeComponentIterator { return { m_data.components.begin(), m_data.components.end() }; }
-		auto end() -> ProxyRuntimeComponentIterator { return { m_data.components.end(), m_data.components.end() }; }
+		ProxyRuntimeComponentView(EntityManager* manager, EntityId entity) : m_manager(manager), m_entity(entity) {}
+		auto begin() -> ProxyRuntimeComponentIterator { return { m_manager, m_entity, 0 }; }
+		auto end() -> ProxyRuntimeComponentIterator { return { m_manager, m_entity, MaxComponentTypes }; }
 	};
 
 	struct ProxyEntityIterator {
-		using InternalIter = decltype(EntityManager::m_entities)::iterator;
-		mutable InternalIter m_iter;
-		mutable InternalIter m_end;
+		mutable EntityId m_id;
+		EntityId m_end;
 		EntityManager& m_manager;
 	public:
 
 		auto& operator++() noexcept
 		{
-			++m_iter;
-			while(m_iter < m_end && m_manager.m_isFree[m_iter->id])
-				++m_iter;
+			++m_id;
+			while(m_id < m_end && m_manager.m_isFree[m_id])
+				++m_id;
 			return *this;
 		}
 
-		ProxyEntityIterator(InternalIter iter, InternalIter end, EntityManager& manager) 
-			: m_iter(iter), m_end(end), m_manager(manager) {
-			if(m_iter < m_end && m_manager.m_isFree[m_iter->id])
+		ProxyEntityIterator(EntityId id, EntityId end, EntityManager& manager) 
+			: m_id(id), m_end(end), m_manager(manager) {
+			if(m_id < m_end && m_manager.m_isFree[m_id])
 				++(*this);
 		}
 
 		const auto& operator++() const noexcept
 		{
-			++m_iter;
-			while(m_iter < m_end && m_manager.m_isFree[m_iter->id])
-				++m_iter;
+			++m_id;
+			while(m_id < m_end && m_manager.m_isFree[m_id])
+				++m_id;
 			return *this;
 		}
 
 		Entity operator*() noexcept
 		{
-			return { m_iter->id, &m_manager };
+			return { m_id, &m_manager };
 		}
 
 		const Entity operator*() const noexcept
 		{
-			return { m_iter->id, &m_manager };
+			return { m_id, &m_manager };
 		}
 
 		friend bool operator==(const ProxyEntityIterator& a, const ProxyEntityIterator& b) noexcept
 		{
-			return a.m_iter == b.m_iter;
+			return a.m_id == b.m_id;
 		}
 
 		friend bool operator!=(const ProxyEntityIterator& a, const ProxyEntityIterator& b) noexcept
 		{
-			return a.m_iter != b.m_iter;
+			return a.m_id != b.m_id;
 		}
 	};
 
@@ -818,14 +1661,16 @@ namespace ark {
 	public:
 		ProxyEntitiesView(EntityManager& m) : m_manager(m) {}
 
-		auto begin() -> ProxyEntityIterator { return {m_manager.m_entities.begin(), m_manager.m_entities.end(), m_manager}; }
-		auto end() -> ProxyEntityIterator { return {m_manager.m_entities.end(), m_manager.m_entities.end(), m_manager}; }
-		auto begin() const -> const ProxyEntityIterator { return {m_manager.m_entities.begin(), m_manager.m_entities.end(), m_manager}; }
-		auto end() const -> const ProxyEntityIterator { return {m_manager.m_entities.end(), m_manager.m_entities.end(), m_manager}; }
+		auto begin() -> ProxyEntityIterator { return {0, size(), m_manager}; }
+		auto end() -> ProxyEntityIterator { return {size(), size(), m_manager}; }
+		auto begin() const -> const ProxyEntityIterator { return {0, size(), m_manager}; }
+		auto end() const -> const ProxyEntityIterator { return {size(), size(), m_manager}; }
+	private:
+		auto size() const -> EntityId { return static_cast<EntityId>(m_manager.m_masks.size()); }
 	};
 
 	inline ProxyRuntimeComponentView EntityManager::eachComponent(EntityId entityId){
-		return {getEntity(entityId)};
+		return {this, entityId};
 	}
 
 	inline ProxyEntitiesView EntityManager::each()
@@ -857,6 +1702,11 @@ namespace ark {
 		manager->add(*this, type, entity);
 	}
 
+	inline void Entity::add(const meta::Metadata& mdata, Entity entity)
+	{
+		manager->add(*this, mdata, entity);
+	}
+
 	inline void* Entity::get(std::type_index type)
 	{
 		auto comp = manager->get(*this, type);
@@ -865,6 +1715,14 @@ namespace ark {
 		return comp;
 	}
 
+	inline void* Entity::get(const meta::Metadata& mdata)
+	{
+		auto comp = manager->get(*this, mdata);
+		if(!comp)
+			EngineLog(LogSource::EntityM, LogLevel::Error, ">:( \n going to crash..."); // going to crash...
+		return comp;
+	}
+
 	template <typename F>
 	requires std::invocable<F, RuntimeComponent>
 	inline void Entity::eachComponent(F&& f)
@@ -883,7 +1741,13 @@ namespace ark {
 	[[nodiscard]]
 	inline const T* Entity::tryGet() const
 	{
-		return manager->tryGet<T>(*this);
+		return manager->tryGet<const T>(*this);
+	}
+
+	template <ConceptComponent T, std::invocable<T&> F>
+	inline bool Entity::patch(F&& fun)
+	{
+		return manager->patch<T>(*this, std::forward<F>(fun));
 	}
 
 	template <ConceptComponent T>
@@ -897,6 +1761,11 @@ namespace ark {
 		manager->remove(*this, type);
 	}
 
+	inline void Entity::remove(const meta::Metadata& mdata)
+	{
+		manager->remove(*this, mdata);
+	}
+
 	inline auto Entity::eachComponent() //-> ProxyRuntimeComponentView
 	{
 		return manager->eachComponent(*this);
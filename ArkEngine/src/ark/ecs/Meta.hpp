@@ -67,6 +67,9 @@ auto registerMembers<YourClass>()
 #include <optional>
 #include <sstream>
 #include <span>
+#include <bit>
+#include <atomic>
+#include <mutex>
 
 /* for example usage see the registration of ark::Transform for members and for enum see RandomNumbers.hpp */
 
@@ -230,15 +233,63 @@ namespace ark::meta
 		ss << value;
 	};
 
+	namespace detail {
+		// offset of a data member, the Class isn't constructed
+		template <typename Class, typename T>
+		std::size_t memberOffset(member_ptr_t<Class, T> ptr) noexcept
+		{
+			alignas(Class) std::byte storage[sizeof(Class)];
+			const auto* object = reinterpret_cast<const Class*>(storage);
+			return static_cast<std::size_t>(reinterpret_cast<const std::byte*>(&(object->*ptr)) - storage);
+		}
+	}
+
 	template <typename, typename = void>
 	inline auto dummy = 0;
 
+	/* Proprietatile data member au offset-ul in clasa: address(), get<T>() si set<T>() sunt un load/store, fara std::any si alocari
+	 * Cele cu getter/setter trec prin std::function; get<T>()/set<T>() merg si pentru ele, std::any doar prin get()/set(std::any)
+	*/
 	class RuntimeProperty {
 
 	public:
 		const std::type_index type;
 		const std::string_view name;
 		const bool isEnum;
+		const std::size_t size; // sizeof the property
+
+		static constexpr std::size_t NoOffset = static_cast<std::size_t>(-1);
+
+		// true for data members
+		bool hasAddress() const noexcept { return m_offset != NoOffset; }
+
+		// the member inside 'instance', nullptr if the property has a getter/setter
+		void* address(void* instance) const noexcept {
+			return hasAddress() ? static_cast<std::byte*>(instance) + m_offset : nullptr;
+		}
+		const void* address(const void* instance) const noexcept {
+			return hasAddress() ? static_cast<const std::byte*>(instance) + m_offset : nullptr;
+		}
+
+		// T must be the type of the property
+		template <typename T>
+		T get(const void* instance) const {
+			assert(type == typeid(T));
+			if (const void* member = address(instance))
+				return *static_cast<const T*>(member);
+			T value{};
+			m_getter(instance, &value);
+			return value;
+		}
+
+		template <typename T>
+		void set(void* instance, const std::type_identity_t<T>& value) const {
+			assert(type == typeid(T));
+			if (void* member = address(instance))
+				*static_cast<T*>(member) = value;
+			else
+				m_setter(instance, const_cast<T*>(&value));
+		}
 
 		// works on class instances
 		void get(const void* instance, void* out_value) const {
@@ -269,7 +320,7 @@ namespace ark::meta
 		}
 
 		std::string toString(const void* instance) const {
-			return m_toString(instance);
+			return m_toString(*this, instance);
 		}
 
 		/* helpers for the property itself*/
@@ -293,7 +344,7 @@ namespace ark::meta
 
 		template <typename Class, typename Property>
 		RuntimeProperty(std::string_view name, ark::meta::member_ptr_t<Class, Property> ptr)
-			: RuntimeProperty(name, std::type_identity<Class>{}, std::type_identity<Property>{}, ptr, ptr)
+			: RuntimeProperty(name, std::type_identity<Class>{}, std::type_identity<Property>{}, ptr, ptr, detail::memberOffset(ptr))
 		{ }
 
 		template <typename Class, typename Property>
@@ -314,8 +365,8 @@ namespace ark::meta
 
 	private:
 		template <typename Class, typename Property, typename GetT, typename SetT>
-		RuntimeProperty(std::string_view name, std::type_identity<Class>, std::type_identity<Property>, GetT ptrGet, SetT ptrSet) 
-			: name(name), type(typeid(Property)), isEnum(std::is_enum_v<Property>),
+		RuntimeProperty(std::string_view name, std::type_identity<Class>, std::type_identity<Property>, GetT ptrGet, SetT ptrSet, std::size_t offset = NoOffset) 
+			: name(name), type(typeid(Property)), isEnum(std::is_enum_v<Property>), size(sizeof(Property)), m_offset(offset),
 			m_fromAny([](std::any& data) { return static_cast<void*>(&std::any_cast<Property&>(data)); }),
 			m_toIntFromEnum([](std::any& any) {
 			if constexpr (std::is_enum_v<Property>)
@@ -349,12 +400,15 @@ namespace ark::meta
 				else
 					std::invoke(ptrSet, static_cast<Class*>(instance), std::any_cast<Property>(in_value));
 		}),
-			m_toString([this](const void* instance) {
-				std::any any = this->get(instance);
-				const Property& prop = std::any_cast<const Property&>(any);
+			m_toString([](const RuntimeProperty& self, const void* instance) {
 				if constexpr (printable<Property>) {
 					std::stringstream ss;
-					ss << prop;
+					if (const void* member = self.address(instance))
+						ss << *static_cast<const Property*>(member);
+					else {
+						std::any any = self.get(instance);
+						ss << std::any_cast<const Property&>(any);
+					}
 					return ss.str();
 				}
 				return std::string();
@@ -368,7 +422,8 @@ namespace ark::meta
 		})
 		{}
 
-		std::function<std::string(const void*)> m_toString;
+		const std::size_t m_offset;
+		std::string (* const m_toString)(const RuntimeProperty&, const void*);
 		void (* const m_toIntFromEnum)(std::any&);
 		void (* const m_toEnumFromInt)(std::any&);
 		void* (* const m_fromAny)(std::any&);
@@ -428,14 +483,30 @@ namespace ark::meta
 		}
 	}
 
+	namespace detail
+	{
+		// set when a type is registered or renamed, resolve(name) rebuilds the name table after that
+		inline std::atomic<bool>& fsNamesChanged() {
+			static std::atomic<bool> sChanged = true;
+			return sChanged;
+		}
+
+		// taken to rebuild the name table, so two threads calling resolve(name) don't build it at the same time
+		inline std::mutex& fsNameTableMutex() {
+			static std::mutex sMutex;
+			return sMutex;
+		}
+	}
+
 	class Metadata {
 		std::string m_name;
-		void setName(const std::string& name) { m_name = name; }
+		void setName(const std::string& name) { m_name = name; detail::fsNamesChanged() = true; }
 	public:
 
 		const std::type_index type;
 		const std::size_t size;
 		const std::size_t align;
+		const std::size_t index; // dense, in order of registration, can be used to index arrays
 
 		const std::string& getName() const { return m_name; }
 		__declspec(property(get=getName, put=setName))
@@ -450,6 +521,8 @@ namespace ark::meta
 		void(*move_constructor)(void*, void*) = nullptr;
 		void(*move_assign)(void*, void*) = nullptr;
 
+		bool trivially_copyable = false; // can be copied with memcpy
+
 		template <typename T>
 		friend Metadata* type(std::string name) noexcept;
 
@@ -511,8 +584,8 @@ namespace ark::meta
 		std::unordered_map<std::string_view, std::any> m_funcs;
 
 		template <typename T>
-		Metadata(std::type_identity<T>, std::string name)
-			: type(typeid(T)), size(sizeof(T)), align(alignof(T)), m_name(name) 
+		Metadata(std::type_identity<T>, std::string name, std::size_t index)
+			: type(typeid(T)), size(sizeof(T)), align(alignof(T)), index(index), m_name(name) 
 		{}
 	};
 
@@ -579,6 +652,106 @@ namespace ark::meta
 			static std::unordered_map<std::type_index, Metadata> sTypeTable;
 			return sTypeTable;
 		}
+
+		// Metadata::index -> Metadata, pointerii din unordered_map sunt stabili
+		inline auto fsTypeIndex() -> std::vector<Metadata*>& {
+			static std::vector<Metadata*> sTypeIndex;
+			return sTypeIndex;
+		}
+
+		/* perfect hash (hash and displace) pentru numele tipurilor
+		 * numele sunt impartite in bucket-uri, fiecare bucket are un seed ales la build astfel incat
+		 * numele lui sa cada in sloturi libere, deci find() face doua hash-uri si o singura comparatie
+		*/
+		class NameTable {
+		public:
+			void build(std::span<Metadata* const> types)
+			{
+				std::vector<Metadata*> unique;
+				unique.reserve(types.size());
+				for (auto* mdata : types) {
+					// la nume duplicate il pastram pe primul inregistrat
+					if (std::none_of(unique.begin(), unique.end(), [&](auto* other) { return other->getName() == mdata->getName(); }))
+						unique.push_back(mdata);
+				}
+
+				std::size_t slotCount = std::bit_ceil(std::max<std::size_t>(2, unique.size() * 2));
+				while (!tryBuild(unique, slotCount))
+					slotCount *= 2;
+			}
+
+			auto find(std::string_view name) const -> Metadata*
+			{
+				if (m_slots.empty())
+					return nullptr;
+				auto bucket = hash(name, 0) & (m_seeds.size() - 1);
+				auto* mdata = m_slots[hash(name, m_seeds[bucket]) & (m_slots.size() - 1)];
+				return mdata && mdata->getName() == name ? mdata : nullptr;
+			}
+
+		private:
+			static auto hash(std::string_view name, std::uint64_t seed) -> std::uint64_t
+			{
+				// FNV-1a
+				std::uint64_t h = 14695981039346656037ull ^ (seed * 0x9E3779B97F4A7C15ull);
+				for (char c : name) {
+					h ^= static_cast<unsigned char>(c);
+					h *= 1099511628211ull;
+				}
+				return h ^ (h >> 29);
+			}
+
+			bool tryBuild(const std::vector<Metadata*>& types, std::size_t slotCount)
+			{
+				const std::size_t bucketCount = std::bit_ceil(std::max<std::size_t>(1, types.size()));
+				std::vector<std::vector<Metadata*>> buckets(bucketCount);
+				for (auto* mdata : types)
+					buckets[hash(mdata->getName(), 0) & (bucketCount - 1)].push_back(mdata);
+
+				std::vector<std::size_t> order(bucketCount);
+				for (std::size_t i = 0; i < bucketCount; i++)
+					order[i] = i;
+				std::sort(order.begin(), order.end(), [&](auto a, auto b) { return buckets[a].size() > buckets[b].size(); });
+
+				m_slots.assign(slotCount, nullptr);
+				m_seeds.assign(bucketCount, 0);
+				std::vector<std::size_t> taken;
+				for (auto bucket : order) {
+					if (buckets[bucket].empty())
+						break;
+					bool placed = false;
+					for (std::uint64_t seed = 1; seed < 4096 && !placed; seed++) {
+						taken.clear();
+						placed = true;
+						for (auto* mdata : buckets[bucket]) {
+							auto slot = hash(mdata->getName(), seed) & (slotCount - 1);
+							if (m_slots[slot] || std::find(taken.begin(), taken.end(), slot) != taken.end()) {
+								placed = false;
+								break;
+							}
+							taken.push_back(slot);
+						}
+						if (placed) {
+							m_seeds[bucket] = seed;
+							for (std::size_t i = 0; i < taken.size(); i++)
+								m_slots[taken[i]] = buckets[bucket][i];
+						}
+					}
+					if (!placed)
+						return false;
+				}
+				return true;
+			}
+
+		private:
+			std::vector<Metadata*> m_slots;
+			std::vector<std::uint64_t> m_seeds; // bucket -> seed
+		};
+
+		inline auto fsNameTable() -> NameTable& {
+			static NameTable sNameTable;
+			return sNameTable;
+		}
 		struct guard {
 			static inline std::unordered_map<std::string_view, std::vector<std::type_index>> sTypeGroups;
 		};
@@ -708,7 +881,7 @@ namespace ark::meta
 		}
 		if (name.empty())
 			name = detail::prettifyTypeName(typeid(T).name());
-		auto metadata = Metadata{ std::type_identity<T>{}, std::move(name) };
+		auto metadata = Metadata{ std::type_identity<T>{}, std::move(name), detail::fsTypeIndex().size() };
 
 		if constexpr (std::is_default_constructible_v<T>)
 			metadata.default_constructor = [](void* This) { new(This)T{}; };
@@ -725,20 +898,43 @@ namespace ark::meta
 		if constexpr (std::is_move_assignable_v<T>)
 			metadata.move_assign = [](void* This, void* That) { *static_cast<T*>(This) = std::move(*static_cast<T*>(That)); };
 
+		metadata.trivially_copyable = std::is_trivially_copyable_v<T>;
+
 		if constexpr (std::is_destructible_v<T>)
 			metadata.destructor = [](void* This) { static_cast<T*>(This)->~T(); };
 
-		return &(detail::fsTypeTable().emplace(typeid(T), std::move(metadata)).first->second);
+		auto* registered = &(detail::fsTypeTable().emplace(typeid(T), std::move(metadata)).first->second);
+		detail::fsTypeIndex().push_back(registered);
+		detail::fsNamesChanged() = true;
+		return registered;
 	}
 
 	inline auto resolve(std::type_index type) noexcept -> Metadata*
 	{
-		if (detail::fsTypeTable().count(type))
-			return &detail::fsTypeTable().at(type);
+		auto& table = detail::fsTypeTable();
+		if (auto it = table.find(type); it != table.end())
+			return &it->second;
 		else
 			return nullptr;
 	}
 
+	// by Metadata::index
+	inline auto resolve(std::size_t index) noexcept -> Metadata*
+	{
+		auto& types = detail::fsTypeIndex();
+		return index < types.size() ? types[index] : nullptr;
+	}
+
+	/* (re)builds the name table used by resolve(name), done lazily by resolve after a type is registered or renamed
+	 * resolve(name) is thread-safe, registering or renaming types while other threads resolve names is not
+	*/
+	inline void buildNameTable() noexcept
+	{
+		std::scoped_lock lock(detail::fsNameTableMutex());
+		detail::fsNameTable().build(detail::fsTypeIndex());
+		detail::fsNamesChanged().store(false, std::memory_order_release);
+	}
+
 	template <typename T>
 	inline auto resolve() noexcept -> Metadata* {
 		return resolve(typeid(T));
@@ -746,11 +942,15 @@ namespace ark::meta
 
 	inline auto resolve(std::string_view name) noexcept -> Metadata*
 	{
-		for (auto& [type, mdata] : detail::fsTypeTable()) {
-			if (mdata.name == name)
-				return &mdata;
+		if (detail::fsNamesChanged().load(std::memory_order_acquire)) {
+			// the first thread rebuilds it, the others wait for it and find it built
+			std::scoped_lock lock(detail::fsNameTableMutex());
+			if (detail::fsNamesChanged().load(std::memory_order_relaxed)) {
+				detail::fsNameTable().build(detail::fsTypeIndex());
+				detail::fsNamesChanged().store(false, std::memory_order_release);
+			}
 		}
-		return nullptr;
+		return detail::fsNameTable().find(name);
 	}
 
 	inline bool hasProperties(std::type_index type) {
@@ -0,0 +1,364 @@
+#include <fstream>
+#include <algorithm>
+#include "ark/ecs/PrefabLibrary.hpp"
+#include "ark/ecs/EntityManager.hpp"
+#include "ark/ecs/Meta.hpp"
+#include "ark/ecs/components/Transform.hpp"
+
+namespace ark {
+
+	static constexpr char sMagic[4] = { 'A', 'R', 'K', 'P' };
+	static constexpr std::uint32_t sVersion = 1;
+	// the payload starts aligned to this, the Raw components are aligned inside it
+	static constexpr std::size_t sPayloadAlign = 64;
+
+	static auto alignUp(std::size_t offset, std::size_t align) -> std::size_t
+	{
+		return (offset + align - 1) / align * align;
+	}
+
+	// registered with registerServicePrefabRaw<T>()
+	static bool isRaw(const meta::Metadata& mdata)
+	{
+		const auto* raw = mdata.data<bool>(servicePrefabRawName);
+		return mdata.trivially_copyable && raw && *raw;
+	}
+
+	template <typename T>
+	static void append(std::vector<std::byte>& out, std::span<const T> items)
+	{
+		const auto* bytes = reinterpret_cast<const std::byte*>(items.data());
+		out.insert(out.end(), bytes, bytes + items.size_bytes());
+	}
+
+	auto PrefabLibrary::pack(std::span<const Entity> prefabs) -> std::vector<std::byte>
+	{
+		using nlohmann::json;
+
+		struct Prefab {
+			std::string name;
+			Entity entity;
+		};
+		std::vector<Prefab> sorted;
+		for (auto entity : prefabs) {
+			const auto* tag = entity.tryGet<const TagComponent>();
+			if (!tag || tag->name.empty()) {
+				EngineLog(LogSource::Registry, LogLevel::Warning, "prefab library: entity (%d) has no name, it's left out", entity.getID());
+				continue;
+			}
+			sorted.push_back({ tag->name, entity });
+		}
+		std::stable_sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.name < b.name; });
+
+		std::vector<TypeRecord> types;
+		std::vector<const meta::Metadata*> typeMetadata;
+		std::vector<PrefabRecord> prefabRecords;
+		std::vector<ComponentRecord> components;
+		std::vector<char> names;
+		std::vector<std::byte> payload;
+		std::vector<std::size_t> inSchema; // the components with the offset in the schema data
+		serde::BinaryWriter schema;
+
+		auto addName = [&names](std::string_view name) {
+			auto offset = static_cast<std::uint32_t>(names.size());
+			names.insert(names.end(), name.begin(), name.end());
+			return offset;
+		};
+
+		// index in 'types' or -1 if the type can't be stored
+		auto typeOf = [&](const meta::Metadata& mdata) -> int {
+			for (std::size_t i = 0; i < typeMetadata.size(); i++)
+				if (typeMetadata[i] == &mdata)
+					return static_cast<int>(i);
+
+			TypeRecord type{ .size = static_cast<std::uint32_t>(mdata.size), .align = static_cast<std::uint32_t>(mdata.align) };
+			const auto* binary = serde::binaryTypeOf(mdata);
+			// memcpy only for the types that opted in, trivially copyable types can still hold pointers
+			if (isRaw(mdata) && mdata.align <= sPayloadAlign)
+				type.encoding = Encoding::Raw;
+			else if (binary) {
+				type.encoding = Encoding::Properties;
+				type.schemaType = schema.typeIndex(mdata, binary);
+			}
+			else if (mdata.func<json(const void*)>(serde::serviceSerializeName))
+				type.encoding = Encoding::Json;
+			else
+				return ArkInvalidIndex;
+			type.nameSize = static_cast<std::uint32_t>(mdata.name.size());
+			type.name = addName(mdata.name);
+			types.push_back(type);
+			typeMetadata.push_back(&mdata);
+			return static_cast<int>(types.size() - 1);
+		};
+
+		for (std::size_t p = 0; p < sorted.size(); p++) {
+			auto& [name, entity] = sorted[p];
+			if (p > 0 && sorted[p - 1].name == name) {
+				EngineLog(LogSource::Registry, LogLevel::Warning, "prefab library: prefab (%s) is duplicated, the first one is kept", name);
+				continue;
+			}
+			PrefabRecord prefab{ .nameSize = static_cast<std::uint32_t>(name.size()), .firstComponent = static_cast<std::uint32_t>(components.size()) };
+			prefab.name = addName(name);
+
+			for (const RuntimeComponent component : entity.eachComponent()) {
+				const auto& mdata = *component.metadata;
+				const int typeIndex = typeOf(mdata);
+				if (typeIndex == ArkInvalidIndex)
+					continue;
+				const auto& type = types[typeIndex];
+				ComponentRecord record{ .type = static_cast<std::uint32_t>(typeIndex) };
+				switch (type.encoding) {
+				case Encoding::Raw: {
+					record.offset = alignUp(payload.size(), mdata.align);
+					record.size = type.size;
+					payload.resize(record.offset);
+					const auto* bytes = static_cast<const std::byte*>(component.ptr);
+					payload.insert(payload.end(), bytes, bytes + mdata.size);
+					break;
+				}
+				case Encoding::Properties: {
+					record.offset = schema.size();
+					serde::binaryTypeOf(mdata)->writeObject(schema, component.ptr);
+					record.size = static_cast<std::uint32_t>(schema.size() - record.offset);
+					inSchema.push_back(components.size());
+					break;
+				}
+				case Encoding::Json: {
+					auto serialize = mdata.func<json(const void*)>(serde::serviceSerializeName);
+					auto cbor = json::to_cbor(serialize(component.ptr));
+					record.offset = payload.size();
+					record.size = static_cast<std::uint32_t>(cbor.size());
+					const auto* bytes = reinterpret_cast<const std::byte*>(cbor.data());
+					payload.insert(payload.end(), bytes, bytes + cbor.size());
+					break;
+				}
+				}
+				components.push_back(record);
+				prefab.componentCount++;
+			}
+			prefabRecords.push_back(prefab);
+		}
+
+		const auto schemaDataSize = schema.size();
+		const auto schemaBytes = schema.finish();
+		const auto schemaHeaderSize = schemaBytes.size() - schemaDataSize;
+
+		FileHeader header{};
+		std::copy(std::begin(sMagic), std::end(sMagic), header.magic);
+		header.version = sVersion;
+		header.typeCount = static_cast<std::uint32_t>(types.size());
+		header.prefabCount = static_cast<std::uint32_t>(prefabRecords.size());
+		header.componentCount = static_cast<std::uint32_t>(components.size());
+		header.namesSize = static_cast<std::uint32_t>(names.size());
+		header.types = sizeof(FileHeader);
+		header.prefabs = header.types + sizeof(TypeRecord) * types.size();
+		header.components = header.prefabs + sizeof(PrefabRecord) * prefabRecords.size();
+		header.names = header.components + sizeof(ComponentRecord) * components.size();
+		const auto payloadOffset = alignUp(header.names + names.size(), sPayloadAlign);
+		header.schema = payloadOffset + payload.size();
+		header.schemaSize = schemaBytes.size();
+
+		for (auto& record : components)
+			record.offset += payloadOffset;
+		for (auto i : inSchema)
+			components[i].offset += header.schema + schemaHeaderSize - payloadOffset;
+
+		std::vector<std::byte> out;
+		out.reserve(header.schema + schemaBytes.size());
+		append(out, std::span<const FileHeader>(&header, 1));
+		append(out, std::span<const TypeRecord>(types));
+		append(out, std::span<const PrefabRecord>(prefabRecords));
+		append(out, std::span<const ComponentRecord>(components));
+		append(out, std::span<const char>(names));
+		out.resize(payloadOffset);
+		append(out, std::span<const std::byte>(payload));
+		append(out, std::span<const std::byte>(schemaBytes));
+		return out;
+	}
+
+	bool PrefabLibrary::packToFile(std::span<const Entity> prefabs, const std::string& path)
+	{
+		auto data = pack(prefabs);
+		std::ofstream of(path, std::ios::binary);
+		of.write(reinterpret_cast<const char*>(data.data()), data.size());
+		return static_cast<bool>(of);
+	}
+
+	bool PrefabLibrary::open(const std::string& path)
+	{
+		close();
+		if (!m_file.open(path)) {
+			EngineLog(LogSource::Registry, LogLevel::Error, "prefab library: can't open (%s)", path);
+			return false;
+		}
+
+		const auto bytes = m_file.bytes();
+		auto fail = [&](const char* reason) {
+			EngineLog(LogSource::Registry, LogLevel::Error, "prefab library (%s): %s", path, reason);
+			close();
+			return false;
+		};
+		// [offset, offset + count * sizeof(T)) inside the file
+		auto table = [&]<typename T>(std::type_identity<T>, std::uint64_t offset, std::uint64_t count) -> std::span<const T> {
+			if (offset > bytes.size() || count > (bytes.size() - offset) / sizeof(T))
+				return {};
+			return { reinterpret_cast<const T*>(bytes.data() + offset), static_cast<std::size_t>(count) };
+		};
+
+		auto header = table(std::type_identity<FileHeader>{}, 0, 1);
+		if (header.empty() || !std::equal(std::begin(sMagic), std::end(sMagic), header[0].magic))
+			return fail("not a prefab library");
+		const auto& h = header[0];
+		if (h.version != sVersion)
+			return fail("version is not supported, pack it again");
+
+		m_typeRecords = table(std::type_identity<TypeRecord>{}, h.types, h.typeCount);
+		m_prefabs = table(std::type_identity<PrefabRecord>{}, h.prefabs, h.prefabCount);
+		m_components = table(std::type_identity<ComponentRecord>{}, h.components, h.componentCount);
+		m_names = table(std::type_identity<char>{}, h.names, h.namesSize);
+		if (m_typeRecords.size() != h.typeCount || m_prefabs.size() != h.prefabCount
+			|| m_components.size() != h.componentCount || m_names.size() != h.namesSize
+			|| table(std::type_identity<std::byte>{}, h.schema, h.schemaSize).size() != h.schemaSize)
+			return fail("truncated");
+
+		for (const auto& type : m_typeRecords)
+			if (std::uint64_t{ type.name } + type.nameSize > m_names.size())
+				return fail("corrupted type table");
+		for (const auto& prefab : m_prefabs)
+			if (std::uint64_t{ prefab.name } + prefab.nameSize > m_names.size()
+				|| std::uint64_t{ prefab.firstComponent } + prefab.componentCount > m_components.size())
+				return fail("corrupted prefab table");
+		for (const auto& component : m_components) {
+			if (component.type >= m_typeRecords.size() || component.offset > bytes.size() || component.size > bytes.size() - component.offset)
+				return fail("corrupted component table");
+			// instantiate copies the size of the type, checked against the type table below
+			if (m_typeRecords[component.type].encoding == Encoding::Raw && component.size != m_typeRecords[component.type].size)
+				return fail("corrupted component table");
+		}
+
+		m_schemaOffset = h.schema;
+		m_schema = serde::BinaryReader(bytes.subspan(h.schema, h.schemaSize));
+		if (h.schemaSize && !m_schema.readHeader())
+			return fail("corrupted schema");
+
+		// resolved once, instantiate only indexes m_types
+		m_types.resize(m_typeRecords.size());
+		for (std::size_t i = 0; i < m_typeRecords.size(); i++) {
+			const auto& record = m_typeRecords[i];
+			const auto name = nameOf(record.name, record.nameSize);
+			auto& type = m_types[i];
+			const auto* mdata = meta::resolve(name);
+			if (!mdata) {
+				EngineLog(LogSource::Registry, LogLevel::Warning, "prefab library: unknown component (%s), it's skipped", std::string(name));
+				continue;
+			}
+			switch (record.encoding) {
+			case Encoding::Raw:
+				if (!isRaw(*mdata) || mdata->size != record.size || mdata->align != record.align) {
+					EngineLog(LogSource::Registry, LogLevel::Error,
+						"prefab library: the layout or the encoding of (%s) changed, it's skipped, pack the library again", mdata->name);
+					continue;
+				}
+				break;
+			case Encoding::Properties:
+				type.binary = serde::binaryTypeOf(*mdata);
+				if (!type.binary) {
+					EngineLog(LogSource::Registry, LogLevel::Error, "prefab library: component (%s) has no binary service", mdata->name);
+					continue;
+				}
+				break;
+			case Encoding::Json:
+				if (!mdata->func<void(Entity&, const nlohmann::json&, void*)>(serde::serviceDeserializeName)) {
+					EngineLog(LogSource::Registry, LogLevel::Error, "prefab library: component (%s) has no deserialize service", mdata->name);
+					continue;
+				}
+				break;
+			default:
+				return fail("corrupted type table");
+			}
+			type.metadata = mdata;
+		}
+		return true;
+	}
+
+	void PrefabLibrary::close()
+	{
+		m_typeRecords = {};
+		m_prefabs = {};
+		m_components = {};
+		m_names = {};
+		m_schemaOffset = 0;
+		m_types.clear();
+		m_schema = serde::BinaryReader(std::span<const std::byte>{});
+		m_file.close();
+	}
+
+	auto PrefabLibrary::nameOf(std::uint32_t offset, std::uint32_t size) const -> std::string_view
+	{
+		return { m_names.data() + offset, size };
+	}
+
+	auto PrefabLibrary::find(std::string_view name) const -> const PrefabRecord*
+	{
+		auto it = std::lower_bound(m_prefabs.begin(), m_prefabs.end(), name, [this](const PrefabRecord& prefab, std::string_view name) {
+			return nameOf(prefab.name, prefab.nameSize) < name;
+		});
+		if (it == m_prefabs.end() || nameOf(it->name, it->nameSize) != name)
+			return nullptr;
+		return &*it;
+	}
+
+	auto PrefabLibrary::instantiate(EntityManager& manager, std::string_view name) -> Entity
+	{
+		const auto* prefab = find(name);
+		if (!prefab) {
+			EngineLog(LogSource::Registry, LogLevel::Error, "prefab library: no prefab named (%s)", std::string(name));
+			return {};
+		}
+
+		// a corrupted prefab read before doesn't fail this one
+		m_schema.clearFailed();
+		auto entity = manager.createEntity();
+		const auto components = m_components.subspan(prefab->firstComponent, prefab->componentCount);
+		// all the components first, like deserializeEntity, the onAdd signals see the default values
+		for (const auto& component : components)
+			if (const auto* mdata = m_types[component.type].metadata)
+				manager.add(entity.getID(), *mdata);
+
+		const auto* file = m_file.bytes().data();
+		for (const auto& component : components) {
+			const auto& type = m_types[component.type];
+			if (!type.metadata)
+				continue;
+			void* dst = manager.get(entity.getID(), *type.metadata);
+			if (!dst)
+				continue;
+			const auto* src = file + component.offset;
+			switch (m_typeRecords[component.type].encoding) {
+			case Encoding::Raw:
+				// open() checked component.size == TypeRecord::size == Metadata::size
+				std::memcpy(dst, src, type.metadata->size);
+				break;
+			case Encoding::Properties:
+				m_schema.seek(component.offset - m_schemaOffset);
+				type.binary->readObject(m_schema, m_typeRecords[component.type].schemaType, dst);
+				break;
+			case Encoding::Json: {
+				auto deserialize = type.metadata->func<void(Entity&, const nlohmann::json&, void*)>(serde::serviceDeserializeName);
+				const auto* cbor = reinterpret_cast<const std::uint8_t*>(src);
+				auto json = nlohmann::json::from_cbor(cbor, cbor + component.size, true, false);
+				if (json.is_discarded()) {
+					EngineLog(LogSource::Registry, LogLevel::Error, "prefab library: prefab (%s) has invalid json for (%s)",
+						std::string(name), type.metadata->name);
+					break;
+				}
+				deserialize(entity, json, dst);
+				break;
+			}
+			}
+		}
+		if (m_schema.failed())
+			EngineLog(LogSource::Registry, LogLevel::Error, "prefab library: prefab (%s) is corrupted", std::string(name));
+		return entity;
+	}
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+#include "ark/ecs/Entity.hpp"
+#include "ark/ecs/SerdeBinaryDirector.hpp"
+#include "ark/util/MappedFile.hpp"
+
+namespace ark {
+
+	class EntityManager;
+
+	// set by registerServicePrefabRaw<T>(), PrefabLibrary stores T with memcpy
+	static inline std::string_view servicePrefabRawName = "prefab_raw";
+
+	/* Librarie de prefab-uri intr-un singur fisier, mapata in memorie (MappedFile)
+	 *
+	 * fisier: [ header ][ tipuri ][ prefab-uri, sortate dupa nume ][ componente ][ nume ][ payload ][ schema binara ]
+	 * toate tabelele sunt structuri de marime fixa, folosite direct din fisierul mapat, fara parsare
+	 * payload-ul unei componente e, dupa encoding-ul tipului:
+	 *     Raw:        bytes-ii componentei, aliniati, copiati cu memcpy in pool; doar pentru tipurile inregistrate
+	 *                 cu registerServicePrefabRaw<T>() (trivially copyable, fara pointeri sau handle-uri)
+	 *     Properties: proprietatile in formatul din SerdeBinaryDirector, tabela lui de tipuri e citita o data la open()
+	 *     Json:       json in CBOR, pentru tipurile care au doar serviciile json (ex. ScriptingComponent)
+	 *
+	 * Tipurile Raw au marimea si alinierea in tabela; daca s-au schimbat in cod sau tipul nu mai e Raw, componentele
+	 * lor sunt sarite cu o eroare si libraria trebuie refacuta cu pack().
+	 *
+	 * instantiate() nu e thread safe, schema binara tine pozitia de citire.
+	*/
+	class PrefabLibrary final {
+	public:
+		PrefabLibrary() = default;
+		explicit PrefabLibrary(const std::string& path) { open(path); }
+
+		PrefabLibrary(PrefabLibrary&&) noexcept = default;
+		PrefabLibrary& operator=(PrefabLibrary&&) noexcept = default;
+
+		// the entities need a TagComponent, its name is the name of the prefab
+		static auto pack(std::span<const Entity> prefabs) -> std::vector<std::byte>;
+		static bool packToFile(std::span<const Entity> prefabs, const std::string& path);
+
+		// maps the file and resolves the types, false if it's not a valid library
+		bool open(const std::string& path);
+		void close();
+
+		bool isOpen() const { return m_file.isOpen(); }
+
+		// number of prefabs
+		auto size() const -> std::size_t { return m_prefabs.size(); }
+
+		bool contains(std::string_view name) const { return find(name) != nullptr; }
+
+		// a new entity with the components of the prefab, an invalid entity if there's no prefab named 'name'
+		auto instantiate(EntityManager& manager, std::string_view name) -> Entity;
+
+	private:
+		enum class Encoding : std::uint8_t { Raw, Properties, Json };
+
+		struct FileHeader {
+			char magic[4];
+			std::uint32_t version;
+			std::uint32_t typeCount;
+			std::uint32_t prefabCount;
+			std::uint32_t componentCount;
+			std::uint32_t namesSize;
+			std::uint64_t types;
+			std::uint64_t prefabs;
+			std::uint64_t components;
+			std::uint64_t names;
+			std::uint64_t schema;
+			std::uint64_t schemaSize;
+		};
+
+		struct TypeRecord {
+			std::uint32_t name; // offset in the names
+			std::uint32_t nameSize;
+			std::uint32_t size;
+			std::uint32_t align;
+			std::uint32_t schemaType; // index in the type table of the schema, for Properties
+			Encoding encoding;
+			std::uint8_t padding[3];
+		};
+
+		struct PrefabRecord {
+			std::uint32_t name;
+			std::uint32_t nameSize;
+			std::uint32_t firstComponent;
+			std::uint32_t componentCount;
+		};
+
+		struct ComponentRecord {
+			std::uint32_t type;
+			std::uint32_t size;
+			std::uint64_t offset; // in the file
+		};
+
+		struct Type {
+			const meta::Metadata* metadata = nullptr; // nullptr if the components of this type are skipped
+			const serde::BinaryType* binary = nullptr;
+		};
+
+		auto find(std::string_view name) const -> const PrefabRecord*;
+		auto nameOf(std::uint32_t offset, std::uint32_t size) const -> std::string_view;
+
+		MappedFile m_file;
+		std::span<const TypeRecord> m_typeRecords;
+		std::span<const PrefabRecord> m_prefabs;
+		std::span<const ComponentRecord> m_components;
+		std::span<const char> m_names;
+		std::uint64_t m_schemaOffset = 0;
+		std::vector<Type> m_types;
+		serde::BinaryReader m_schema{ std::span<const std::byte>{} };
+	};
+}
+
+/* opts T in the Raw encoding of PrefabLibrary, for components made only of values (no pointers, handles, ids of resources)
+ * ARK_REGISTER_COMPONENT(Velocity, registerServiceDefault<Velocity>(), registerServicePrefabRaw<Velocity>())
+*/
+template <typename T>
+requires std::is_trivially_copyable_v<T>
+inline void registerServicePrefabRaw() {
+	ark::meta::type<T>()->data(ark::servicePrefabRawName, true);
+}
@@ -11,61 +11,316 @@
 
 namespace ark
 {
-	template <typename... Ts>
-	class EntityQuery {
+	/* Lista persistenta cu entitatile care au toate componentele Ts, tinuta la zi din semnalele onAdd/onRemove
+	 * Ts sunt termeni ca la View: Without<T> scoate entitatile cu T, Maybe<T> da T* (nullptr daca lipseste)
+	 *
+	 * entity id -> index, deci scoaterea e O(1) (swap-remove) cat timp lista nu e sortata.
+	 * Dupa sort(compare) ordinea e pastrata: entitatile noi sunt inserate la locul lor (binary search) si scoaterea
+	 * nu mai schimba ordinea. Daca cheile de sortare se schimba, sort() fara argumente reordoneaza cu insertion sort,
+	 * care e aproape O(n) cand doar cateva entitati s-au mutat.
+	 *
+	 * Starea e pe heap si callback-urile tin pointer la ea, deci query-ul poate fi mutat.
+	 *
+	 * bCache: tine si pointerii la componente langa id-uri, doar cu StoragePolicy::SparseSet (pointerii sunt stabili,
+	 * dupa EntityManager::compact() sunt luati din nou).
+	 * Scrierile prin pointerii din cache nu marcheaza componentele ca schimbate (vezi Changed<T>).
+	*/
+	template <bool bCache, ConceptViewTerm... Ts>
+	class BasicEntityQuery {
+		static_assert(((detail::view_term<Ts>::filter == ViewFilter::None) && ...), "EntityQuery nu are filtre Changed/Added, foloseste un View");
+
+		using Compare = std::function<bool(ark::Entity, ark::Entity)>;
+		using Components = std::tuple<view_component_t<Ts>*...>; // nullptr for Without<T> and missing Maybe<T>
+
+		struct State {
+			ark::EntityManager* manager = nullptr;
+			ark::ViewMask mask;
+			std::vector<ark::Entity> entities;
+			std::vector<Components> components; // only with bCache, index as in 'entities'
+			std::vector<int> indexOf; // entity id -> index in 'entities', ArkInvalidIndex if missing
+			std::vector<ark::EntityId> pending; // lost a Without<T> component, checked by flush()
+			Compare compare; // empty if the order doesn't matter
+			bool modified = false;
+
+			void insert(ark::Entity entity)
+			{
+				if (entity.getID() >= indexOf.size())
+					indexOf.resize(entity.getID() + 1, ArkInvalidIndex);
+				else if (indexOf[entity.getID()] != ArkInvalidIndex)
+					return;
+
+				auto index = entities.size();
+				if (compare)
+					index = std::upper_bound(entities.begin(), entities.end(), entity, compare) - entities.begin();
+				entities.insert(entities.begin() + index, entity);
+				if constexpr (bCache)
+					components.insert(components.begin() + index, Components{ cached<Ts>(entity)... });
+				reindex(index, entities.size());
+				modified = true;
+			}
+
+			void erase(ark::EntityId entity)
+			{
+				if (entity >= indexOf.size() || indexOf[entity] == ArkInvalidIndex)
+					return;
+				std::size_t index = indexOf[entity];
+				indexOf[entity] = ArkInvalidIndex;
+				if (compare) {
+					entities.erase(entities.begin() + index);
+					if constexpr (bCache)
+						components.erase(components.begin() + index);
+					reindex(index, entities.size());
+				}
+				else {
+					entities[index] = entities.back();
+					entities.pop_back();
+					if constexpr (bCache) {
+						components[index] = components.back();
+						components.pop_back();
+					}
+					reindex(index, std::min(index + 1, entities.size()));
+				}
+				modified = true;
+			}
+
+			void reindex(std::size_t begin, std::size_t end)
+			{
+				for (auto i = begin; i < end; i++)
+					indexOf[entities[i].getID()] = static_cast<int>(i);
+			}
+
+			// onRemove is published before the component is removed, so the entities that lost a Without<T> are checked later
+			void flush()
+			{
+				if (pending.empty())
+					return;
+				for (auto entity : pending)
+					if (manager->isValid(entity) && mask.matches(manager->mask(entity)))
+						insert(ark::Entity{ entity, manager });
+				pending.clear();
+			}
+
+			// after EntityManager::compact() the components may be somewhere else
+			void recache()
+			{
+				for (std::size_t i = 0; i < entities.size(); i++)
+					components[i] = Components{ cached<Ts>(entities[i].getID())... };
+			}
+
+			// fara sa le marcam ca schimbate
+			template <typename T>
+			auto cached(ark::EntityId entity) const -> view_component_t<T>* {
+				using C = std::remove_const_t<view_component_t<T>>;
+				if constexpr (view_term_kind_v<T> == ViewTermKind::Excluded)
+					return nullptr;
+				else
+					return const_cast<C*>(manager->template tryGet<const C>(entity));
+			}
+
+			// what term I gives for the entity at 'index', see view_term_yield_t
+			template <std::size_t I>
+			auto values(std::size_t index) -> view_term_yield_t<std::tuple_element_t<I, std::tuple<Ts...>>> {
+				using T = std::tuple_element_t<I, std::tuple<Ts...>>;
+				if constexpr (!bCache)
+					return detail::viewTerm<T>(*manager, entities[index].getID());
+				else if constexpr (view_term_kind_v<T> == ViewTermKind::Excluded)
+					return {};
+				else if constexpr (view_term_kind_v<T> == ViewTermKind::Optional)
+					return view_term_yield_t<T>{ std::get<I>(components[index]) };
+				else
+					return view_term_yield_t<T>{ *std::get<I>(components[index]) };
+			}
+		};
+
+		std::unique_ptr<State> m_state = std::make_unique<State>();
 		std::vector<ScopedConnection> m_conns;
-		std::vector<ark::Entity> m_entities;
-		ark::ComponentMask m_mask;
-		bool m_modified = false;
 
 	public:
-		EntityQuery(ark::EntityManager& man) {
+		BasicEntityQuery(ark::EntityManager& man) {
 			this->connect(man);
-			man.idFromType<Ts...>(m_mask);
-			man.view<Ts...>().each([&, this](ark::Entity ent) {
-				m_entities.push_back(ent);
-			});
 		}
-		EntityQuery() = default;
-		EntityQuery(EntityQuery&&) = default;
+		BasicEntityQuery() = default;
+		BasicEntityQuery(BasicEntityQuery&&) = default;
+		BasicEntityQuery& operator=(BasicEntityQuery&&) = default;
+
+		auto begin() const { return entities().begin(); }
+		auto end() const { return entities().end(); }
+
+		auto size() const -> std::size_t { return entities().size(); }
+		auto operator[](std::size_t index) const -> ark::Entity { return entities()[index]; }
+
+		// index in the query, ArkInvalidIndex if the entity is not part of it
+		int indexOf(ark::EntityId entity) const {
+			m_state->flush();
+			auto& indexOf = m_state->indexOf;
+			return entity >= 0 && entity < indexOf.size() ? indexOf[entity] : ArkInvalidIndex;
+		}
 
-		auto begin() { return m_entities.begin(); }
-		auto end() { return m_entities.end(); }
+		bool contains(ark::EntityId entity) const { return indexOf(entity) != ArkInvalidIndex; }
 
+		// adds the entities that already match and follows the manager from now on
 		void connect(ark::EntityManager& man) {
-			(man.addType(typeid(Ts)), ...);
-			(m_conns.emplace_back(man.onAdd<Ts>().connect([this](ark::EntityManager& man, ark::Entity entity) {
-				if ((man.has(entity, m_mask))) {
-					m_modified = true;
-					m_entities.push_back(entity);
+			auto& state = *m_state;
+			if constexpr (bCache) {
+				if (man.storagePolicy() != StoragePolicy::SparseSet) {
+					EngineLog(LogSource::EntityM, LogLevel::Error,
+						"aborting... EntityQuery with cached pointers needs StoragePolicy::SparseSet, component pointers move with archetypes");
+					std::abort();
 				}
-			})), ...);
-			(m_conns.emplace_back(man.onRemove<Ts>().connect([this](ark::EntityManager& man, ark::Entity entity) {
-				m_modified = true;
-				std::erase(m_entities, entity);
-			})), ...);
+			}
+			m_conns.clear();
+			state.manager = &man;
+			state.entities.clear();
+			state.components.clear();
+			state.indexOf.clear();
+			state.pending.clear();
+			(man.addType(typeid(view_component_t<Ts>)), ...);
+			state.mask = {};
+			[&]<std::size_t... Is>(std::index_sequence<Is...>) {
+				(connectTerm<Is>(man), ...);
+			}(std::index_sequence_for<Ts...>{});
+			if constexpr (bCache)
+				m_conns.emplace_back(man.onCompact().connect([state = m_state.get()](ark::EntityManager&) {
+					state->recache();
+				}));
+
+			// each<Entity>() doesn't get the components, nothing is marked as changed
+			for (auto view = man.view<Ts...>(); ark::Entity ent : view.template each<ark::Entity>())
+				state.insert(ent);
+			sortAll();
+			state.modified = false;
 		}
 
 		const auto& entities() const {
-			return m_entities;
+			m_state->flush();
+			return m_state->entities;
 		}
 
+		/* f(Entity, values...) with the values of the terms like View: T&, T* for Maybe<T>, nothing for Without<T>
+		 * with bCache the components come from the cache
+		 * don't add/remove the query's components in 'f'
+		*/
 		template <typename F>
-		void sort(F&& f) {
-			std::sort(m_entities.begin(), m_entities.end(), std::forward<F>(f));
+		void each(F&& f) {
+			auto& state = *m_state;
+			state.flush();
+			for (std::size_t i = 0; i < state.entities.size(); i++) {
+				[&]<std::size_t... Is>(std::index_sequence<Is...>) {
+					std::apply(f, std::tuple_cat(std::tuple<ark::Entity>(state.entities[i]), state.template values<Is>(i)...));
+				}(std::index_sequence_for<Ts...>{});
+			}
+		}
+
+		/* keeps the entities ordered by compare(Entity a, Entity b) from now on, stable
+		 * removals keep the order too, so they are O(n) instead of O(1)
+		*/
+		template <typename F>
+		void sort(F&& compare) {
+			m_state->compare = std::forward<F>(compare);
+			sortAll();
+		}
+
+		// reorders after the sort keys changed, cheap when the list is almost sorted
+		void sort() {
+			auto& state = *m_state;
+			state.flush();
+			if (!state.compare)
+				return;
+			for (std::size_t i = 1; i < state.entities.size(); i++) {
+				for (std::size_t j = i; j > 0 && state.compare(state.entities[j], state.entities[j - 1]); j--) {
+					std::swap(state.entities[j], state.entities[j - 1]);
+					if constexpr (bCache)
+						std::swap(state.components[j], state.components[j - 1]);
+				}
+			}
+			state.reindex(0, state.entities.size());
+		}
+
+		// back to unordered, removals are O(1) again
+		void unsort() {
+			m_state->compare = nullptr;
+		}
+
+		// nothing to rebuild anymore, the query is kept up to date; only resets the dirty flag
+		void reconstruct(ark::EntityManager&) {
+			m_state->modified = false;
 		}
 
-		void reconstruct(ark::EntityManager& manager) {
-			if (m_modified) {
-				m_entities.clear();
-				for (auto view = manager.view<Ts...>(); ark::Entity ent : view.each<ark::Entity>())
-					m_entities.push_back(ent);
-				m_modified = false;
+		// true if entities were added/removed since connect() or the last clearDirty()
+		bool isDirty() const {
+			return m_state->modified;
+		}
+
+		void clearDirty() {
+			m_state->modified = false;
+		}
+
+	private:
+		template <std::size_t I>
+		void connectTerm(ark::EntityManager& man) {
+			using T = std::tuple_element_t<I, std::tuple<Ts...>>;
+			using C = std::remove_const_t<view_component_t<T>>;
+			auto* state = m_state.get();
+			const int compId = man.idFromType<C>();
+
+			if constexpr (view_term_kind_v<T> == ViewTermKind::Required) {
+				state->mask.include.set(compId);
+				m_conns.emplace_back(man.onAdd<C>().connect([state](ark::EntityManager& manager, ark::Entity entity) {
+					if (state->mask.matches(manager.mask(entity)))
+						state->insert(entity);
+				}));
+				m_conns.emplace_back(man.onRemove<C>().connect([state](ark::EntityManager&, ark::Entity entity) {
+					state->erase(entity);
+				}));
+			}
+			else if constexpr (view_term_kind_v<T> == ViewTermKind::Excluded) {
+				state->mask.exclude.set(compId);
+				m_conns.emplace_back(man.onAdd<C>().connect([state](ark::EntityManager&, ark::Entity entity) {
+					state->erase(entity);
+				}));
+				m_conns.emplace_back(man.onRemove<C>().connect([state](ark::EntityManager&, ark::Entity entity) {
+					state->pending.push_back(entity.getID());
+				}));
+			}
+			else if constexpr (bCache) {
+				// Maybe<T> doesn't change the entities, only the cached pointer
+				m_conns.emplace_back(man.onAdd<C>().connect([state](ark::EntityManager&, ark::Entity entity) {
+					if (int index = state->indexOf.size() > entity.getID() ? state->indexOf[entity.getID()] : ArkInvalidIndex; index != ArkInvalidIndex)
+						std::get<I>(state->components[index]) = state->template cached<T>(entity.getID());
+				}));
+				m_conns.emplace_back(man.onRemove<C>().connect([state](ark::EntityManager&, ark::Entity entity) {
+					if (int index = state->indexOf.size() > entity.getID() ? state->indexOf[entity.getID()] : ArkInvalidIndex; index != ArkInvalidIndex)
+						std::get<I>(state->components[index]) = nullptr;
+				}));
 			}
 		}
 
-		bool isDirty() {
-			return m_modified;
+		void sortAll() {
+			auto& state = *m_state;
+			state.flush();
+			if (!state.compare)
+				return;
+			std::vector<std::size_t> order(state.entities.size());
+			for (std::size_t i = 0; i < order.size(); i++)
+				order[i] = i;
+			std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+				return state.compare(state.entities[a], state.entities[b]);
+			});
+			auto entities = state.entities;
+			auto components = state.components;
+			for (std::size_t i = 0; i < order.size(); i++) {
+				state.entities[i] = entities[order[i]];
+				if constexpr (bCache)
+					state.components[i] = components[order[i]];
+			}
+			state.reindex(0, state.entities.size());
 		}
 	};
+
+	template <typename... Ts>
+	using EntityQuery = BasicEntityQuery<false, Ts...>;
+
+	// keeps the component pointers next to the ids, needs StoragePolicy::SparseSet
+	template <typename... Ts>
+	using CachedEntityQuery = BasicEntityQuery<true, Ts...>;
 }
@@ -176,11 +176,18 @@ namespace ark {
 
 			if (ark::meta::hasProperties(property.type)) {
 				// recursively render members that are registered
-				std::any propValue = property.get(pInstance);
 				ImGui::Text("--%s:", property.name.data());
-				if (renderPropertiesOfType(property.type, widgetId, property.fromAny(propValue), type, property.name)) {
-					property.set(pInstance, propValue);
-					modified = true;
+				if (void* member = property.address(pInstance)) {
+					// edited in place
+					if (renderPropertiesOfType(property.type, widgetId, member, type, property.name))
+						modified = true;
+				}
+				else {
+					std::any propValue = property.get(pInstance);
+					if (renderPropertiesOfType(property.type, widgetId, property.fromAny(propValue), type, property.name)) {
+						property.set(pInstance, propValue);
+						modified = true;
+					}
 				}
 			}
 			else if (property.isEnum) {
@@ -240,8 +247,14 @@ namespace ark {
 					return defaultOpt;
 				}(); 
 
-				std::any local = property.get(pInstance);
-				if (auto newValue = renderProperty(property.name, property.fromAny(local), editopt); newValue.has_value()) {
+				// data members are read in place, std::any only for getters and for the edited value
+				std::any local;
+				const void* field = property.address(pInstance);
+				if (!field) {
+					local = property.get(pInstance);
+					field = property.fromAny(local);
+				}
+				if (auto newValue = renderProperty(property.name, field, editopt); newValue.has_value()) {
 					property.set(pInstance, newValue);
 					modified = true;
 				}
@@ -300,14 +313,14 @@ namespace ark {
 				// edit component
 				for (ark::RuntimeComponent component : selectedEntity.eachComponent()) {
 					ImGui::AlignTextToFramePadding();
-					const auto* mdata = ark::meta::resolve(component.type);
+					const auto* mdata = component.metadata;
 					auto flags = ImGuiTreeNodeFlags_DefaultOpen | ImGuiTreeNodeFlags_AllowItemOverlap | ImGuiTreeNodeFlags_SpanAvailWidth;
 					if (ImGui::TreeNodeEx(mdata->name.c_str(), flags)) {
 						// can't delete Tag or Transform
 						bool deleted = false;
 						if (component.type != typeid(TagComponent) && component.type != typeid(ark::Transform)) {
 							deleted = AlignButtonToRight("remove component", [&]() {
-								selectedEntity.remove(component.type);
+								selectedEntity.remove(*mdata);
 							});
 						}
 						if (!deleted) {
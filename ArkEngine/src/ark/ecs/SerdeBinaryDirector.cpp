@@ -0,0 +1,255 @@
+#include <fstream>
+#include <iterator>
+#include "ark/ecs/SerdeBinaryDirector.hpp"
+#include "ark/ecs/Entity.hpp"
+#include "ark/ecs/EntityManager.hpp"
+#include "ark/ecs/Meta.hpp"
+#include "ark/util/ResourceManager.hpp"
+#include "ark/ecs/components/Transform.hpp"
+
+namespace ark::serde
+{
+	static inline const std::string sEntityFolder = Resources::resourceFolder + "entities/";
+	static constexpr char sMagic[4] = { 'A', 'R', 'K', 'B' };
+	static constexpr std::uint32_t sVersion = 1;
+
+	static std::string getEntityBinaryFilePath(std::string_view name)
+	{
+		return sEntityFolder + name.data() + ".arkb";
+	}
+
+	auto BinaryWriter::finish() -> std::vector<std::byte>
+	{
+		BinaryWriter header;
+		header.writeBytes(sMagic, sizeof(sMagic));
+		header.write(sVersion);
+		header.write(static_cast<std::uint32_t>(m_types.size()));
+		// the Object types were added with their owners, typeIndex below only finds them
+		for (std::size_t i = 0; i < m_types.size(); i++) {
+			const auto [mdata, type] = m_types[i];
+			header.writeString(mdata->name);
+			header.write(type ? BinaryEncoding::Properties : BinaryEncoding::Json);
+			header.write(static_cast<std::uint32_t>(type ? type->props.size() : 0));
+			if (!type)
+				continue;
+			for (const auto& prop : type->props) {
+				header.writeString(prop.name);
+				header.write(prop.kind);
+				std::uint32_t extra = 0;
+				if (prop.kind == BinaryKind::Object)
+					extra = typeIndex(*prop.object().metadata, &prop.object());
+				else if (prop.kind == BinaryKind::Raw)
+					extra = prop.size;
+				header.write(extra);
+			}
+		}
+		header.writeBytes(m_data.data(), m_data.size());
+		return std::move(header.m_data);
+	}
+
+	bool BinaryReader::readHeader()
+	{
+		auto magic = readBytes(sizeof(sMagic));
+		if (m_failed || std::memcmp(magic.data(), sMagic, sizeof(sMagic)) != 0)
+			return false;
+		if (auto version = read<std::uint32_t>(); version != sVersion) {
+			EngineLog(LogSource::Registry, LogLevel::Error, "binary entities: version (%u) is not supported", version);
+			return false;
+		}
+		auto typeCount = read<std::uint32_t>();
+		for (std::uint32_t i = 0; i < typeCount && !m_failed; i++) {
+			auto& type = m_types.emplace_back();
+			type.name = readString();
+			type.encoding = read<BinaryEncoding>();
+			type.metadata = meta::resolve(type.name);
+			auto propCount = read<std::uint32_t>();
+			for (std::uint32_t p = 0; p < propCount && !m_failed; p++) {
+				auto& prop = type.props.emplace_back();
+				prop.name = readString();
+				prop.kind = read<BinaryKind>();
+				prop.extra = read<std::uint32_t>();
+			}
+		}
+		return !m_failed;
+	}
+
+	void BinaryReader::skip(const BinarySchema::Property& prop)
+	{
+		switch (prop.kind) {
+		case BinaryKind::Bool: case BinaryKind::I8: case BinaryKind::U8:
+			readBytes(1); break;
+		case BinaryKind::I16: case BinaryKind::U16:
+			readBytes(2); break;
+		case BinaryKind::I32: case BinaryKind::U32: case BinaryKind::F32:
+			readBytes(4); break;
+		case BinaryKind::I64: case BinaryKind::U64: case BinaryKind::F64:
+			readBytes(8); break;
+		case BinaryKind::String: case BinaryKind::Enum: case BinaryKind::Json:
+			readBytes(read<std::uint32_t>()); break;
+		case BinaryKind::Raw:
+			readBytes(prop.extra); break;
+		case BinaryKind::Object:
+			if (auto* type = this->type(prop.extra))
+				for (const auto& nested : type->props)
+					skip(nested);
+			break;
+		default:
+			m_failed = true;
+		}
+	}
+
+	namespace detail {
+		void mapBinaryType(BinaryReader& reader, BinarySchema::Type& fileType, const BinaryType& type)
+		{
+			fileType.mappedTo = &type;
+			fileType.mapping.assign(fileType.props.size(), nullptr);
+			for (std::size_t i = 0; i < fileType.props.size(); i++) {
+				const auto& fileProp = fileType.props[i];
+				for (const auto& prop : type.props) {
+					if (fileProp.name != prop.name || fileProp.kind != prop.kind)
+						continue;
+					if (prop.kind == BinaryKind::Raw && fileProp.extra != prop.size)
+						continue;
+					if (prop.kind == BinaryKind::Object) {
+						auto* nested = reader.type(fileProp.extra);
+						if (!nested || nested->name != prop.object().metadata->name)
+							continue;
+					}
+					fileType.mapping[i] = &prop;
+					break;
+				}
+			}
+		}
+	}
+
+	static bool isSerializable(const meta::Metadata& mdata)
+	{
+		return binaryTypeOf(mdata) || mdata.func<nlohmann::json(const void*)>(serviceSerializeName);
+	}
+
+	static void writeEntity(BinaryWriter& writer, ark::Entity entity)
+	{
+		std::uint32_t count = 0;
+		for (const RuntimeComponent component : entity.eachComponent())
+			if (isSerializable(*component.metadata))
+				count++;
+		writer.write(count);
+
+		for (const RuntimeComponent component : entity.eachComponent()) {
+			const auto& mdata = *component.metadata;
+			if (!isSerializable(mdata))
+				continue;
+			const auto* type = binaryTypeOf(mdata);
+			writer.write(writer.typeIndex(mdata, type));
+			auto begin = writer.beginSize();
+			if (type)
+				type->writeObject(writer, component.ptr);
+			else {
+				auto serialize = mdata.func<nlohmann::json(const void*)>(serviceSerializeName);
+				auto cbor = nlohmann::json::to_cbor(serialize(component.ptr));
+				writer.writeBytes(cbor.data(), cbor.size());
+			}
+			writer.endSize(begin);
+		}
+	}
+
+	// adds all the components of the entity, then reads them, like deserializeEntity
+	static void readEntity(BinaryReader& reader, ark::Entity entity)
+	{
+		struct Pending {
+			std::uint32_t type;
+			std::size_t position;
+			std::size_t size;
+		};
+		std::vector<Pending> pending;
+		auto count = reader.read<std::uint32_t>();
+		for (std::uint32_t i = 0; i < count && !reader.failed(); i++) {
+			auto typeIndex = reader.read<std::uint32_t>();
+			auto size = reader.read<std::uint32_t>();
+			auto position = reader.position();
+			reader.readBytes(size);
+			auto* type = reader.type(typeIndex);
+			if (!type || reader.failed())
+				return;
+			if (!type->metadata) {
+				EngineLog(LogSource::Registry, LogLevel::Warning, "binary entities: unknown component (%s) skipped", type->name);
+				continue;
+			}
+			entity.add(*type->metadata);
+			pending.push_back({ typeIndex, position, size });
+		}
+
+		const auto end = reader.position();
+		for (auto [typeIndex, position, size] : pending) {
+			const auto* type = reader.type(typeIndex);
+			void* component = entity.get(*type->metadata);
+			if (!component)
+				continue;
+			reader.seek(position);
+			if (type->encoding == BinaryEncoding::Json) {
+				auto deserialize = type->metadata->func<void(Entity&, const nlohmann::json&, void*)>(serviceDeserializeName);
+				auto bytes = reader.readBytes(size);
+				if (!deserialize || reader.failed())
+					continue;
+				auto json = readCbor(reader, bytes);
+				if (reader.failed())
+					break;
+				deserialize(entity, json, component);
+			}
+			else if (const auto* binary = binaryTypeOf(*type->metadata))
+				binary->readObject(reader, typeIndex, component);
+			else
+				EngineLog(LogSource::Registry, LogLevel::Warning, "binary entities: component (%s) has no binary service", type->name);
+		}
+		reader.seek(end);
+	}
+
+	auto serializeEntitiesBinary(std::span<const ark::Entity> entities) -> std::vector<std::byte>
+	{
+		BinaryWriter writer;
+		writer.write(static_cast<std::uint32_t>(entities.size()));
+		for (auto entity : entities)
+			writeEntity(writer, entity);
+		return writer.finish();
+	}
+
+	auto deserializeEntitiesBinary(ark::EntityManager& manager, std::span<const std::byte> data) -> std::vector<ark::Entity>
+	{
+		BinaryReader reader(data);
+		if (!reader.readHeader()) {
+			EngineLog(LogSource::Registry, LogLevel::Error, "binary entities: the data is not in the binary format");
+			return {};
+		}
+		// the entities read before an error are kept
+		std::vector<ark::Entity> entities;
+		const auto count = reader.read<std::uint32_t>();
+		for (std::uint32_t i = 0; i < count && !reader.failed(); i++) {
+			auto entity = manager.createEntity();
+			readEntity(reader, entity);
+			entities.push_back(entity);
+		}
+		if (reader.failed())
+			EngineLog(LogSource::Registry, LogLevel::Error, "binary entities: the data is truncated or corrupted");
+		return entities;
+	}
+
+	void serializeEntityBinary(ark::Entity entity)
+	{
+		auto data = serializeEntitiesBinary(std::span<const ark::Entity>(&entity, 1));
+		std::ofstream of(getEntityBinaryFilePath(entity.get<TagComponent>().name), std::ios::binary);
+		of.write(reinterpret_cast<const char*>(data.data()), data.size());
+	}
+
+	void deserializeEntityBinary(ark::Entity entity)
+	{
+		std::ifstream fin(getEntityBinaryFilePath(entity.get<TagComponent>().name), std::ios::binary);
+		std::vector<char> file{ std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>() };
+		BinaryReader reader(std::as_bytes(std::span(file)));
+		if (!reader.readHeader() || reader.read<std::uint32_t>() != 1) {
+			EngineLog(LogSource::Registry, LogLevel::Error, "deser-ing entity (%s): not a binary file with one entity",
+				entity.get<TagComponent>().name);
+			return;
+		}
+		readEntity(reader, entity);
+	}
+}
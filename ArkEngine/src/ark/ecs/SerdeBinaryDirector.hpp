@@ -0,0 +1,379 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <span>
+#include <cstring>
+#include <cstdint>
+#include <bit>
+
+#include "ark/core/Core.hpp"
+#include "ark/ecs/Meta.hpp"
+#include "ark/ecs/Entity.hpp"
+#include "ark/ecs/SerdeJsonDirector.hpp"
+
+/* Format binar pentru entitati/prefab-uri, generat din proprietatile din meta (meta::doForAllProperties)
+ *
+ * fisier: [ "ARKB" ][ u32 versiune ][ tabela de tipuri ][ u32 nr. entitati ][ entitati ]
+ * tabela: u32 nr. tipuri, per tip: nume, u8 encoding, u32 nr. proprietati, per proprietate: nume, u8 kind, u32 extra
+ *         extra = indexul tipului in tabela pentru Object, sizeof pentru Raw
+ * entitate: u32 nr. componente, per componenta: u32 index in tabela, u32 bytes, valorile proprietatilor in ordinea din tabela
+ *
+ * Numele apar o singura data, in tabela. La citire proprietatile sunt potrivite dupa nume si kind, deci
+ * proprietatile sterse din cod sunt sarite, iar cele noi raman cu valoarea default. Componentele de tipuri
+ * necunoscute sunt sarite (au marimea in fata).
+ * Tipurile fara membri inregistrati dar cu serviciul json (ex. ScriptingComponent) sunt scrise ca json in CBOR.
+ * Valorile sunt little endian, asa cum sunt in memorie.
+*/
+
+namespace ark::serde
+{
+	void serializeEntityBinary(ark::Entity e);
+
+	void deserializeEntityBinary(ark::Entity e);
+
+	auto serializeEntitiesBinary(std::span<const ark::Entity> entities) -> std::vector<std::byte>;
+
+	// creates the entities from 'data', returns nothing if 'data' isn't valid
+	auto deserializeEntitiesBinary(ark::EntityManager& manager, std::span<const std::byte> data) -> std::vector<ark::Entity>;
+
+	static inline std::string_view serviceBinaryName = "binary";
+
+	static_assert(std::endian::native == std::endian::little, "the binary format is little endian");
+
+	enum class BinaryKind : std::uint8_t {
+		Bool, I8, U8, I16, U16, I32, U32, I64, U64, F32, F64,
+		String, // u32 size, chars
+		Enum,   // name, like String
+		Object, // registered type, its properties
+		Raw,    // trivially copyable and not registered (sf::Vector2f, sf::Color), memcpy
+		Json,   // the rest, json in CBOR, u32 size first
+	};
+
+	enum class BinaryEncoding : std::uint8_t { Properties, Json };
+
+	class BinaryWriter;
+	class BinaryReader;
+	struct BinaryType;
+	struct BinaryProperty;
+
+	struct BinarySchema {
+		struct Property {
+			std::string name;
+			BinaryKind kind;
+			std::uint32_t extra;
+		};
+		struct Type {
+			std::string name;
+			BinaryEncoding encoding;
+			std::vector<Property> props;
+			const meta::Metadata* metadata = nullptr; // nullptr if the type isn't registered anymore
+			// file property -> current property, built on the first read
+			const BinaryType* mappedTo = nullptr;
+			std::vector<const BinaryProperty*> mapping;
+		};
+	};
+
+	// built on the first call, sMembers<T> may not be initialized yet when the services are registered
+	using BinaryTypeGetter = const BinaryType& (*)();
+
+	struct BinaryProperty {
+		const char* name;
+		BinaryKind kind;
+		std::uint32_t size; // sizeof, checked for Raw
+		BinaryTypeGetter object = nullptr; // for Object
+		void (*write)(BinaryWriter&, const void* obj) = nullptr;
+		void (*read)(BinaryReader&, const BinarySchema::Property&, void* obj) = nullptr;
+	};
+
+	// the binary service of a type, see binaryType<T>()
+	struct BinaryType {
+		const meta::Metadata* metadata;
+		std::vector<BinaryProperty> props;
+		void (*writeObject)(BinaryWriter&, const void* obj) = nullptr;
+		void (*readObject)(BinaryReader&, std::uint32_t fileType, void* obj) = nullptr;
+	};
+
+	class BinaryWriter {
+	public:
+		template <typename T>
+		requires std::is_trivially_copyable_v<T>
+		void write(const T& value) { writeBytes(&value, sizeof(T)); }
+
+		void writeBytes(const void* data, std::size_t size)
+		{
+			auto at = m_data.size();
+			m_data.resize(at + size);
+			if (size)
+				std::memcpy(m_data.data() + at, data, size);
+		}
+
+		void writeString(std::string_view str)
+		{
+			write(static_cast<std::uint32_t>(str.size()));
+			writeBytes(str.data(), str.size());
+		}
+
+		// u32 placeholder, patched by endSize with the bytes written after it
+		auto beginSize() -> std::size_t
+		{
+			write(std::uint32_t{ 0 });
+			return m_data.size();
+		}
+
+		void endSize(std::size_t begin)
+		{
+			auto size = static_cast<std::uint32_t>(m_data.size() - begin);
+			std::memcpy(m_data.data() + begin - sizeof(size), &size, sizeof(size));
+		}
+
+		// index in the type table, adds the type (and the types of its Object properties) the first time
+		auto typeIndex(const meta::Metadata& metadata, const BinaryType* type) -> std::uint32_t
+		{
+			for (std::uint32_t i = 0; i < m_types.size(); i++)
+				if (m_types[i].first == &metadata)
+					return i;
+			const auto index = static_cast<std::uint32_t>(m_types.size());
+			m_types.emplace_back(&metadata, type);
+			if (type)
+				for (const auto& prop : type->props)
+					if (prop.object)
+						typeIndex(*prop.object().metadata, &prop.object());
+			return index;
+		}
+
+		// bytes written so far, without the header and the type table
+		auto size() const -> std::size_t { return m_data.size(); }
+
+		// header, type table, then what was written so far
+		auto finish() -> std::vector<std::byte>;
+
+	private:
+		std::vector<std::byte> m_data;
+		std::vector<std::pair<const meta::Metadata*, const BinaryType*>> m_types;
+	};
+
+	class BinaryReader {
+	public:
+		explicit BinaryReader(std::span<const std::byte> data) : m_data(data) {}
+
+		// reads the header and the type table, false if the data isn't in the binary format
+		bool readHeader();
+
+		template <typename T>
+		requires std::is_trivially_copyable_v<T>
+		T read()
+		{
+			T value{};
+			if (auto bytes = readBytes(sizeof(T)); !bytes.empty())
+				std::memcpy(&value, bytes.data(), sizeof(T));
+			return value;
+		}
+
+		auto readBytes(std::size_t size) -> std::span<const std::byte>
+		{
+			if (m_failed || size > m_data.size() - m_pos) {
+				m_failed = true;
+				return {};
+			}
+			auto bytes = m_data.subspan(m_pos, size);
+			m_pos += size;
+			return bytes;
+		}
+
+		auto readString() -> std::string_view
+		{
+			auto bytes = readBytes(read<std::uint32_t>());
+			return { reinterpret_cast<const char*>(bytes.data()), bytes.size() };
+		}
+
+		void skip(const BinarySchema::Property& prop);
+
+		auto position() const -> std::size_t { return m_pos; }
+		void seek(std::size_t position) { m_pos = std::min(position, m_data.size()); }
+
+		auto type(std::uint32_t index) -> BinarySchema::Type*
+		{
+			if (index >= m_types.size()) {
+				m_failed = true;
+				return nullptr;
+			}
+			return &m_types[index];
+		}
+
+		bool failed() const { return m_failed; }
+		void fail() { m_failed = true; }
+		// the data and the type table stay, only the error is forgotten
+		void clearFailed() { m_failed = false; }
+
+	private:
+		std::span<const std::byte> m_data;
+		std::size_t m_pos = 0;
+		bool m_failed = false;
+		std::vector<BinarySchema::Type> m_types;
+	};
+
+	// the json of a Json value, the reader fails (and the json is discarded) if the cbor is invalid, nothing throws
+	inline auto readCbor(BinaryReader& reader, std::span<const std::byte> bytes) -> nlohmann::json
+	{
+		if (reader.failed())
+			return nlohmann::json(nlohmann::json::value_t::discarded);
+		const auto* cbor = reinterpret_cast<const std::uint8_t*>(bytes.data());
+		auto json = nlohmann::json::from_cbor(cbor, cbor + bytes.size(), true, false);
+		if (json.is_discarded())
+			reader.fail();
+		return json;
+	}
+
+	// the binary service, or nullptr if the type is written as json
+	inline auto binaryTypeOf(const meta::Metadata& mdata) -> const BinaryType*
+	{
+		auto binary = mdata.data<BinaryTypeGetter>(serviceBinaryName);
+		return binary ? &(*binary)() : nullptr;
+	}
+
+	template <typename T>
+	constexpr BinaryKind binaryKind()
+	{
+		if constexpr (meta::isRegistered<T>())
+			return BinaryKind::Object;
+		else if constexpr (std::is_enum_v<T>)
+			return BinaryKind::Enum;
+		else if constexpr (std::is_same_v<T, bool>)
+			return BinaryKind::Bool;
+		else if constexpr (std::is_integral_v<T>) {
+			constexpr bool s = std::is_signed_v<T>;
+			if constexpr (sizeof(T) == 1) return s ? BinaryKind::I8 : BinaryKind::U8;
+			else if constexpr (sizeof(T) == 2) return s ? BinaryKind::I16 : BinaryKind::U16;
+			else if constexpr (sizeof(T) == 4) return s ? BinaryKind::I32 : BinaryKind::U32;
+			else return s ? BinaryKind::I64 : BinaryKind::U64;
+		}
+		else if constexpr (std::is_same_v<T, float>)
+			return BinaryKind::F32;
+		else if constexpr (std::is_same_v<T, double>)
+			return BinaryKind::F64;
+		else if constexpr (std::is_same_v<T, std::string>)
+			return BinaryKind::String;
+		else if constexpr (std::is_trivially_copyable_v<T>)
+			return BinaryKind::Raw;
+		else
+			return BinaryKind::Json;
+	}
+
+	template <typename T>
+	const BinaryType& binaryType();
+
+	template <typename T>
+	void writeValue(BinaryWriter& writer, const T& value)
+	{
+		constexpr auto kind = binaryKind<T>();
+		if constexpr (kind == BinaryKind::Object)
+			binaryType<T>().writeObject(writer, &value);
+		else if constexpr (kind == BinaryKind::Enum)
+			writer.writeString(meta::getNameOfEnumValue<T>(value));
+		else if constexpr (kind == BinaryKind::String)
+			writer.writeString(value);
+		else if constexpr (kind == BinaryKind::Json) {
+			auto cbor = nlohmann::json::to_cbor(nlohmann::json(value));
+			writer.write(static_cast<std::uint32_t>(cbor.size()));
+			writer.writeBytes(cbor.data(), cbor.size());
+		}
+		else
+			writer.write(value);
+	}
+
+	template <typename T>
+	void readValue(BinaryReader& reader, const BinarySchema::Property& prop, T& value)
+	{
+		constexpr auto kind = binaryKind<T>();
+		if constexpr (kind == BinaryKind::Object)
+			binaryType<T>().readObject(reader, prop.extra, &value);
+		else if constexpr (kind == BinaryKind::Enum) {
+			// enumerators removed since the file was written keep the current value
+			auto name = reader.readString();
+			if (const auto* fields = meta::getEnumValues<T>())
+				for (const auto& field : *fields)
+					if (field.name == name)
+						value = static_cast<T>(field.value);
+		}
+		else if constexpr (kind == BinaryKind::String)
+			value = reader.readString();
+		else if constexpr (kind == BinaryKind::Json) {
+			auto json = readCbor(reader, reader.readBytes(reader.read<std::uint32_t>()));
+			if (reader.failed())
+				return;
+			value = json.template get<T>();
+		}
+		else
+			value = reader.read<T>();
+	}
+
+	namespace detail {
+
+		// the file properties of 'fileType' in the order of the current properties of 'type', matched by name and kind
+		void mapBinaryType(BinaryReader& reader, BinarySchema::Type& fileType, const BinaryType& type);
+
+		template <typename T, std::size_t I>
+		void addBinaryProperty(BinaryType& type)
+		{
+			const auto& member = std::get<I>(meta::detail::sMembers<T>);
+			if constexpr (std::decay_t<decltype(member)>::isProperty) {
+				using PropType = meta::get_member_type<decltype(member)>;
+				BinaryProperty prop{ .name = member.getName(), .kind = binaryKind<PropType>(), .size = sizeof(PropType) };
+				if constexpr (meta::isRegistered<PropType>())
+					prop.object = &binaryType<PropType>;
+				prop.write = [](BinaryWriter& writer, const void* obj) {
+					const auto& member = std::get<I>(meta::detail::sMembers<T>);
+					writeValue<PropType>(writer, member.getCopy(*static_cast<const T*>(obj)));
+				};
+				prop.read = [](BinaryReader& reader, const BinarySchema::Property& fileProp, void* obj) {
+					const auto& member = std::get<I>(meta::detail::sMembers<T>);
+					auto& value = *static_cast<T*>(obj);
+					// copy first: the properties missing from the file keep their value
+					PropType propValue = member.getCopy(value);
+					readValue(reader, fileProp, propValue);
+					if (!reader.failed())
+						member.set(value, std::move(propValue));
+				};
+				type.props.push_back(prop);
+			}
+		}
+	}
+
+	/* the properties of T with their read/write functions, built once
+	 * addSerdeFunctions puts &binaryType<T> in the Metadata of T (serviceBinaryName)
+	*/
+	template <typename T>
+	const BinaryType& binaryType()
+	{
+		static const BinaryType type = [] {
+			BinaryType type{ meta::type<T>() };
+			constexpr auto count = std::tuple_size_v<std::decay_t<decltype(meta::detail::sMembers<T>)>>;
+			[&]<std::size_t... Is>(std::index_sequence<Is...>) {
+				(detail::addBinaryProperty<T, Is>(type), ...);
+			}(std::make_index_sequence<count>{});
+
+			type.writeObject = [](BinaryWriter& writer, const void* obj) {
+				for (const auto& prop : binaryType<T>().props)
+					prop.write(writer, obj);
+			};
+			type.readObject = [](BinaryReader& reader, std::uint32_t fileTypeIndex, void* obj) {
+				auto* fileType = reader.type(fileTypeIndex);
+				if (!fileType)
+					return;
+				const auto& current = binaryType<T>();
+				if (fileType->mappedTo != &current)
+					detail::mapBinaryType(reader, *fileType, current);
+				for (std::size_t i = 0; i < fileType->props.size() && !reader.failed(); i++) {
+					if (const auto* prop = fileType->mapping[i])
+						prop->read(reader, fileType->props[i], obj);
+					else
+						reader.skip(fileType->props[i]);
+				}
+			};
+			return type;
+		}();
+		return type;
+	}
+}
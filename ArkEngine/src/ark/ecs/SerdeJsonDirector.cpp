@@ -1,9 +1,13 @@
 #include <fstream>
+#include <iterator>
+#include <algorithm>
 #include "ark/ecs/SerdeJsonDirector.hpp"
+#include "ark/ecs/SerdeJsonStream.hpp"
 #include "ark/ecs/Entity.hpp"
 #include "ark/ecs/EntityManager.hpp"
 #include "ark/ecs/Meta.hpp"
 #include "ark/util/ResourceManager.hpp"
+#include "ark/core/JobSystem.hpp"
 #include "ark/ecs/components/Transform.hpp"
 
 namespace ark::serde
@@ -17,47 +21,195 @@ namespace ark::serde
 
 	void serializeEntity(ark::Entity entity)
 	{
-		json jsonEntity;
-
-		auto& jsonComps = jsonEntity["components"];
+		JsonWriter writer;
+		writer.beginObject();
+		writer.key("components");
+		writer.beginObject();
 
 		for (const RuntimeComponent component : entity.eachComponent()) {
-			auto mdata = ark::meta::resolve(component.type);
-			if (auto serialize = mdata->func<nlohmann::json(const void*)>(serviceSerializeName)) {
-				jsonComps[mdata->name] = serialize(component.ptr);
+			auto mdata = component.metadata;
+			if (const auto* type = jsonTypeOf(*mdata)) {
+				writer.key(mdata->name);
+				type->writeObject(writer, component.ptr);
+			}
+			else if (auto serialize = mdata->func<nlohmann::json(const void*)>(serviceSerializeName)) {
+				writer.key(mdata->name);
+				writer.value(serialize(component.ptr));
 			}
 		}
 
-		std::ofstream of(getEntityFilePath(entity.get<TagComponent>().name));
-		of << jsonEntity.dump(4, ' ', true);
-		// TODO: use pmr vector for to_cbor
-		//nlohmann::json::to_bson(jsonEntity);
-		//nlohmann::detail::output_adapter<char> nush;
+		writer.endObject();
+		writer.endObject();
+		std::ofstream of(getEntityFilePath(entity.get<TagComponent>().name), std::ios::binary);
+		of << writer.str();
+	}
+
+	// the text of every component of an entity file, the components with unknown names are skipped
+	static bool splitComponents(std::string_view text, std::string_view entityName,
+		std::vector<std::pair<const meta::Metadata*, std::string_view>>& components)
+	{
+		JsonReader reader(text);
+		std::string_view key;
+		if (reader.beginObject()) {
+			while (reader.nextKey(key)) {
+				if (key != "components") {
+					reader.skipValue();
+					continue;
+				}
+				if (!reader.beginObject())
+					break;
+				while (reader.nextKey(key)) {
+					const auto* mdata = ark::meta::resolve(key);
+					auto value = reader.skipValue();
+					if (mdata)
+						components.emplace_back(mdata, value);
+					else
+						EngineLog(LogSource::Registry, LogLevel::Error, "deser-ing entity (%s) with unknown component (%s)",
+							entityName, key);
+				}
+			}
+		}
+		if (reader.failed()) {
+			EngineLog(LogSource::Registry, LogLevel::Error, "deser-ing entity (%s): invalid json at %d",
+				entityName, reader.position());
+			return false;
+		}
+		return true;
 	}
 
 	void deserializeEntity(ark::Entity entity)
 	{
-		json jsonEntity;
-		std::ifstream fin(getEntityFilePath(entity.get<TagComponent>().name));
-		fin >> jsonEntity;
+		const std::string& name = entity.get<TagComponent>().name;
+		std::ifstream fin(getEntityFilePath(name), std::ios::binary);
+		const std::string text{ std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>() };
+
+		std::vector<std::pair<const meta::Metadata*, std::string_view>> jsonComps;
+		if (!splitComponents(text, name, jsonComps))
+			return;
 
 		// allocate components and default construct
-		auto& jsonComps = jsonEntity.at("components");
-		for (const auto& [compName, _] : jsonComps.items()) {
-			const auto* mdata = ark::meta::resolve(compName);
-			entity.add(mdata->type);
-		}
+		for (const auto& [mdata, _] : jsonComps)
+			entity.add(*mdata);
 
 		// then initialize
 		for (ark::RuntimeComponent component : entity.eachComponent()) {
-			auto mdata = ark::meta::resolve(component.type);
-			if (auto deserialize = mdata->func<void(Entity&, const nlohmann::json&, void*)>(serviceDeserializeName)) {
-				if (auto it = jsonComps.find(mdata->name); it != jsonComps.end())
-					deserialize(entity, *it, component.ptr);
-				else
-					EngineLog(LogSource::Registry, LogLevel::Error, "deser-ing entity (%s) without component (%s)", 
-						entity.get<TagComponent>().name, mdata->name);
+			auto mdata = component.metadata;
+			const auto* type = jsonTypeOf(*mdata);
+			auto deserialize = mdata->func<void(Entity&, const nlohmann::json&, void*)>(serviceDeserializeName);
+			if (!type && !deserialize)
+				continue;
+
+			auto it = std::find_if(jsonComps.begin(), jsonComps.end(), [mdata](const auto& comp) { return comp.first == mdata; });
+			if (it == jsonComps.end()) {
+				EngineLog(LogSource::Registry, LogLevel::Error, "deser-ing entity (%s) without component (%s)", 
+					entity.get<TagComponent>().name, mdata->name);
+				continue;
+			}
+			if (type) {
+				JsonReader value(it->second);
+				type->readObject(value, entity, component.ptr);
+			}
+			else
+				deserialize(entity, json::parse(it->second), component.ptr);
+		}
+	}
+
+	namespace {
+
+		// a component of an entity file, parsed on a job
+		struct ParsedComponent {
+			const meta::Metadata* metadata;
+			std::string_view text; // in ParsedEntity::text
+			bool parsed = false; // 'values' holds the properties, only the setters are left
+			JsonValues values; // the types with the json service
+			nlohmann::json json; // the types with only the nlohmann::json functions
+		};
+
+		// an entity file read and parsed on a job, its components are built on the calling thread
+		struct ParsedEntity {
+			bool loaded = false;
+			std::string text;
+			std::vector<ParsedComponent> components;
+		};
+
+		/* runs on the jobs: reads the file and parses every component in typed values (JsonValues) or json
+		 * no component is constructed and no setter of a component runs here, setters load resources
+		 * (Resources::load isn't thread safe)
+		*/
+		bool readEntityFile(const std::string& name, ParsedEntity& parsed)
+		{
+			std::ifstream fin(getEntityFilePath(name), std::ios::binary);
+			if (!fin) {
+				EngineLog(LogSource::Registry, LogLevel::Error, "deser-ing entity (%s): can't open the file", name);
+				return false;
+			}
+			parsed.text.assign(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+			std::vector<std::pair<const meta::Metadata*, std::string_view>> components;
+			if (!splitComponents(parsed.text, name, components))
+				return false;
+
+			parsed.components.reserve(components.size());
+			for (const auto& [mdata, text] : components) {
+				auto& component = parsed.components.emplace_back(ParsedComponent{ mdata, text });
+				if (const auto* type = jsonTypeOf(*mdata)) {
+					if (type->canParse()) {
+						JsonReader value(text);
+						type->parseObject(value, component.values);
+						component.parsed = true;
+					}
+				}
+				else if (mdata->func<void(Entity&, const nlohmann::json&, void*)>(serviceDeserializeName))
+					component.json = json::parse(text, nullptr, false);
+			}
+			return true;
+		}
+	}
+
+	auto deserializeEntities(EntityManager& manager, std::span<const std::string> names) -> std::vector<Entity>
+	{
+		// built before, so the jobs don't wait for the first one that calls resolve(name) to build it
+		meta::buildNameTable();
+
+		std::vector<ParsedEntity> parsed(names.size());
+		JobSystem::global().parallelFor(names.size(), 1, [&](std::size_t begin, std::size_t end) {
+			for (std::size_t i = begin; i < end; i++)
+				parsed[i].loaded = readEntityFile(names[i], parsed[i]);
+		});
+
+		std::vector<Entity> entities(names.size());
+		for (std::size_t i = 0; i < names.size(); i++) {
+			auto& file = parsed[i];
+			if (!file.loaded)
+				continue;
+			Entity entity = manager.createEntity();
+			// all the components first, like deserializeEntity, the onAdd signals see the default values
+			for (const auto& component : file.components)
+				entity.add(*component.metadata);
+			for (auto& component : file.components) {
+				const auto* mdata = component.metadata;
+				void* ptr = manager.get(entity.getID(), *mdata);
+				if (!ptr)
+					continue;
+				if (const auto* type = jsonTypeOf(*mdata)) {
+					if (component.parsed)
+						type->applyObject(component.values, entity, ptr);
+					else {
+						// not default constructible, read here
+						JsonReader value(component.text);
+						type->readObject(value, entity, ptr);
+					}
+				}
+				else if (auto deserialize = mdata->func<void(Entity&, const nlohmann::json&, void*)>(serviceDeserializeName)) {
+					if (!component.json.is_discarded())
+						deserialize(entity, component.json, ptr);
+					else
+						EngineLog(LogSource::Registry, LogLevel::Error, "deser-ing entity (%s): invalid json for component (%s)",
+							names[i], mdata->name);
+				}
 			}
+			entities[i] = entity;
+			file = {};
 		}
+		return entities;
 	}
-}
\ No newline at end of file
+}
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <string>
+#include <span>
+#include <vector>
 
 #include <nlohmann/json.hpp>
 
@@ -20,6 +22,14 @@ namespace ark::serde
 
 	void deserializeEntity(ark::Entity e);
 
+	/* reads and parses the files of the entities named 'names' on JobSystem::global(), every property in a typed
+	 * value (JsonType::parseObject), then creates the entities on the calling thread, in the order of 'names';
+	 * the components are constructed and the setters of their properties run on the calling thread,
+	 * so the setters don't have to be thread safe
+	 * the entities whose file can't be read are invalid in the result
+	*/
+	auto deserializeEntities(ark::EntityManager& manager, std::span<const std::string> names) -> std::vector<ark::Entity>;
+
 	static inline std::string_view serviceSerializeName = "serialize";
 	static inline std::string_view serviceDeserializeName = "deserialize";
 }
@@ -0,0 +1,346 @@
+#include "ark/ecs/SerdeJsonStream.hpp"
+
+namespace ark::serde
+{
+	void JsonWriter::value(const nlohmann::json& json)
+	{
+		beforeValue();
+		if (m_indent < 0) {
+			m_out += json.dump();
+			return;
+		}
+		// strings can't have new lines in them, every '\n' starts a line of the value
+		const auto text = json.dump(m_indent);
+		for (char c : text) {
+			m_out += c;
+			if (c == '\n')
+				m_out.append(static_cast<std::size_t>(m_depth * m_indent), ' ');
+		}
+	}
+
+	void JsonWriter::writeString(std::string_view str)
+	{
+		static constexpr char hex[] = "0123456789abcdef";
+		m_out += '"';
+		std::size_t plain = 0;
+		for (std::size_t i = 0; i < str.size(); i++) {
+			const auto c = static_cast<unsigned char>(str[i]);
+			if (c >= 0x20 && c != '"' && c != '\\')
+				continue;
+			m_out.append(str.data() + plain, i - plain);
+			plain = i + 1;
+			switch (c) {
+			case '"': m_out += "\\\""; break;
+			case '\\': m_out += "\\\\"; break;
+			case '\b': m_out += "\\b"; break;
+			case '\f': m_out += "\\f"; break;
+			case '\n': m_out += "\\n"; break;
+			case '\r': m_out += "\\r"; break;
+			case '\t': m_out += "\\t"; break;
+			default:
+				m_out += "\\u00";
+				m_out += hex[c >> 4];
+				m_out += hex[c & 0xf];
+			}
+		}
+		m_out.append(str.data() + plain, str.size() - plain);
+		m_out += '"';
+	}
+
+	bool JsonReader::expect(char c)
+	{
+		if (peek() != c || m_failed)
+			return fail();
+		m_pos++;
+		return true;
+	}
+
+	bool JsonReader::nextMember(char close)
+	{
+		const char c = peek();
+		if (m_failed)
+			return false;
+		if (c == close) {
+			m_pos++;
+			return false;
+		}
+		// the first member has no comma before it
+		if (c == ',') {
+			m_pos++;
+			skipSpace();
+		}
+		if (m_pos >= m_text.size())
+			return fail();
+		return true;
+	}
+
+	auto JsonReader::parseString(std::string& scratch) -> std::string_view
+	{
+		if (peek() != '"')
+			return fail(), std::string_view{};
+		const auto begin = ++m_pos;
+		// no escapes: a view in the text
+		while (m_pos < m_text.size() && m_text[m_pos] != '"' && m_text[m_pos] != '\\')
+			m_pos++;
+		if (m_pos >= m_text.size())
+			return fail(), std::string_view{};
+		if (m_text[m_pos] == '"')
+			return m_text.substr(begin, m_pos++ - begin);
+
+		scratch.assign(m_text.substr(begin, m_pos - begin));
+		auto readHex = [this](std::uint32_t& code) {
+			if (m_text.size() - m_pos < 4)
+				return false;
+			auto [end, error] = std::from_chars(m_text.data() + m_pos, m_text.data() + m_pos + 4, code, 16);
+			m_pos += 4;
+			return error == std::errc{} && end == m_text.data() + m_pos;
+		};
+		while (m_pos < m_text.size() && m_text[m_pos] != '"') {
+			char c = m_text[m_pos++];
+			if (c != '\\') {
+				scratch += c;
+				continue;
+			}
+			if (m_pos >= m_text.size())
+				break;
+			switch (c = m_text[m_pos++]) {
+			case 'b': scratch += '\b'; break;
+			case 'f': scratch += '\f'; break;
+			case 'n': scratch += '\n'; break;
+			case 'r': scratch += '\r'; break;
+			case 't': scratch += '\t'; break;
+			case 'u': {
+				std::uint32_t code;
+				if (!readHex(code))
+					return fail(), std::string_view{};
+				// surrogate pair
+				if (code >= 0xD800 && code <= 0xDBFF) {
+					std::uint32_t low;
+					if (m_text.substr(m_pos, 2) != "\\u" || (m_pos += 2, !readHex(low)) || low < 0xDC00 || low > 0xDFFF)
+						return fail(), std::string_view{};
+					code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+				}
+				// utf-8
+				if (code < 0x80)
+					scratch += static_cast<char>(code);
+				else if (code < 0x800) {
+					scratch += static_cast<char>(0xC0 | (code >> 6));
+					scratch += static_cast<char>(0x80 | (code & 0x3F));
+				}
+				else if (code < 0x10000) {
+					scratch += static_cast<char>(0xE0 | (code >> 12));
+					scratch += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+					scratch += static_cast<char>(0x80 | (code & 0x3F));
+				}
+				else {
+					scratch += static_cast<char>(0xF0 | (code >> 18));
+					scratch += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+					scratch += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+					scratch += static_cast<char>(0x80 | (code & 0x3F));
+				}
+				break;
+			}
+			default: scratch += c; // '"', '\\', '/'
+			}
+		}
+		if (m_pos >= m_text.size())
+			return fail(), std::string_view{};
+		m_pos++;
+		return scratch;
+	}
+
+	auto JsonReader::scanNumber() -> std::string_view
+	{
+		const char c = peek();
+		if (m_failed)
+			return {};
+		if (c != '-' && (c < '0' || c > '9')) {
+			skipValue();
+			return {};
+		}
+		const auto begin = m_pos;
+		while (m_pos < m_text.size()) {
+			const char n = m_text[m_pos];
+			if ((n >= '0' && n <= '9') || n == '-' || n == '+' || n == '.' || n == 'e' || n == 'E')
+				m_pos++;
+			else
+				break;
+		}
+		return m_text.substr(begin, m_pos - begin);
+	}
+
+	bool JsonReader::read(bool& b)
+	{
+		const char c = peek();
+		if (c == 't' && m_text.substr(m_pos, 4) == "true") {
+			m_pos += 4;
+			b = true;
+			return true;
+		}
+		if (c == 'f' && m_text.substr(m_pos, 5) == "false") {
+			m_pos += 5;
+			b = false;
+			return true;
+		}
+		skipValue();
+		return false;
+	}
+
+	bool JsonReader::read(std::string& str)
+	{
+		if (peek() != '"') {
+			skipValue();
+			return false;
+		}
+		str = parseString(m_string);
+		return !m_failed;
+	}
+
+	auto JsonReader::skipValue() -> std::string_view
+	{
+		const char c = peek();
+		if (m_failed || c == '\0') {
+			fail();
+			return {};
+		}
+		const auto begin = m_pos;
+		if (c == '"')
+			parseString(m_string);
+		else if (c == '{' || c == '[') {
+			// only the brackets outside of strings count
+			int depth = 0;
+			while (m_pos < m_text.size()) {
+				const char n = m_text[m_pos];
+				if (n == '"') {
+					parseString(m_string);
+					if (m_failed)
+						break;
+					continue;
+				}
+				m_pos++;
+				if (n == '{' || n == '[')
+					depth++;
+				else if ((n == '}' || n == ']') && --depth == 0)
+					break;
+			}
+			if (depth != 0)
+				fail();
+		}
+		else {
+			// numbers, true, false, null
+			while (m_pos < m_text.size() && m_text[m_pos] != ',' && m_text[m_pos] != '}' && m_text[m_pos] != ']'
+				&& m_text[m_pos] != ' ' && m_text[m_pos] != '\n' && m_text[m_pos] != '\r' && m_text[m_pos] != '\t')
+				m_pos++;
+		}
+		return m_text.substr(begin, m_pos - begin);
+	}
+
+	auto JsonType::find(std::string_view name, std::size_t hint) const -> std::size_t
+	{
+		if (hint < props.size() && name == props[hint].name)
+			return hint;
+		auto it = std::lower_bound(byName.begin(), byName.end(), name, [this](std::uint32_t index, std::string_view name) {
+			return std::string_view(props[index].name) < name;
+		});
+		if (it != byName.end() && name == props[*it].name)
+			return *it;
+		return props.size();
+	}
+
+	void JsonType::writeObject(JsonWriter& writer, const void* obj) const
+	{
+		writer.beginObject();
+		for (const auto& prop : props) {
+			writer.key(prop.name);
+			prop.write(writer, obj);
+		}
+		writer.endObject();
+	}
+
+	bool JsonType::readObject(JsonReader& reader, Entity& entity, void* obj) const
+	{
+		if (!reader.beginObject())
+			return false;
+		std::uint64_t read = 0;
+		std::size_t next = 0;
+		std::string_view key;
+		while (reader.nextKey(key)) {
+			const auto index = find(key, next);
+			if (index == props.size()) {
+				reader.skipValue();
+				continue;
+			}
+			if (props[index].read(reader, entity, obj) && index < 64)
+				read |= std::uint64_t{ 1 } << index;
+			next = index + 1;
+		}
+		if (reader.failed())
+			return false;
+		logMissing(read, entity);
+		return true;
+	}
+
+	bool JsonType::parseObject(JsonReader& reader, JsonValues& values) const
+	{
+		values.clear();
+		values.m_type = this;
+		values.m_read = 0;
+		values.m_failed = true;
+		if (!canParse() || !reader.beginObject())
+			return false;
+
+		void* defaults = construct();
+		std::size_t next = 0;
+		std::string_view key;
+		while (reader.nextKey(key)) {
+			const auto index = find(key, next);
+			if (index == props.size()) {
+				reader.skipValue();
+				continue;
+			}
+			if (void* value = props[index].parse(reader, defaults)) {
+				values.m_values.emplace_back(static_cast<std::uint32_t>(index), value);
+				if (index < 64)
+					values.m_read |= std::uint64_t{ 1 } << index;
+			}
+			next = index + 1;
+		}
+		destroy(defaults);
+		values.m_failed = reader.failed();
+		return !values.m_failed;
+	}
+
+	void JsonType::applyObject(JsonValues& values, Entity& entity, void* obj) const
+	{
+		// in the order of the json, like readObject()
+		for (auto [index, value] : values.m_values)
+			props[index].apply(value, obj);
+		if (!values.m_failed)
+			logMissing(values.m_read, entity);
+		values.clear();
+	}
+
+	void JsonType::logMissing(std::uint64_t read, const Entity& entity) const
+	{
+		// only the first 64 properties are checked for missing values
+		for (std::size_t i = 0; i < props.size() && i < 64; i++) {
+			if (read & (std::uint64_t{ 1 } << i))
+				continue;
+			if (metadata)
+				EngineLog(LogSource::Registry, LogLevel::Error,
+					"failed to deser property (%s) on component (%s) on entity (%d)",
+					props[i].name, metadata->name.c_str(), entity.getID());
+			else
+				EngineLog(LogSource::Registry, LogLevel::Error,
+					"failed to deser property (%s) on entity (%d)",
+					props[i].name, entity.getID());
+		}
+	}
+
+	void JsonValues::clear()
+	{
+		for (auto [index, value] : m_values)
+			m_type->props[index].destroy(value);
+		m_values.clear();
+	}
+}
@@ -0,0 +1,541 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cmath>
+
+#include "ark/core/Core.hpp"
+#include "ark/ecs/Meta.hpp"
+#include "ark/ecs/Entity.hpp"
+#include "ark/ecs/SerdeJsonDirector.hpp"
+
+/* Json fara DOM: JsonWriter scrie direct intr-un string, JsonReader citeste pe rand (pull) din text
+ *
+ * Formatul e acelasi cu cel din serialize_value/deserialize_value, fisierele vechi se citesc la fel.
+ * Diferente fata de nlohmann::json::dump: cheile sunt in ordinea proprietatilor (nu sortate) si
+ * textul non-ASCII e scris ca UTF-8, nu ca \uXXXX.
+ *
+ * Per tip (jsonType<T>) e o tabela cu proprietatile sortate dupa nume; la citire cheile sunt cautate
+ * intai la pozitia urmatoare (fisierele scrise de JsonWriter au cheile in ordine), apoi binar in tabela.
+ * Valorile de tipuri pe care nu le stie JsonWriter/JsonReader trec prin nlohmann::json, doar ele.
+*/
+
+namespace ark::serde
+{
+	static inline std::string_view serviceJsonName = "json";
+
+	class JsonWriter {
+	public:
+		// indent < 0 writes everything on one line
+		explicit JsonWriter(int indent = 4) : m_indent(indent) {}
+
+		void beginObject() { begin('{'); }
+		void endObject() { end('}'); }
+		void beginArray() { begin('['); }
+		void endArray() { end(']'); }
+
+		void key(std::string_view name)
+		{
+			separator();
+			writeString(name);
+			m_out += m_indent < 0 ? ":" : ": ";
+			m_afterKey = true;
+		}
+
+		void null()
+		{
+			beforeValue();
+			m_out += "null";
+		}
+
+		void value(bool b)
+		{
+			beforeValue();
+			m_out += b ? "true" : "false";
+		}
+
+		template <typename T>
+		requires (std::is_arithmetic_v<T> && !std::is_same_v<T, bool>)
+		void value(T number)
+		{
+			if constexpr (std::is_floating_point_v<T>) {
+				// like nlohmann::json
+				if (!std::isfinite(number))
+					return null();
+			}
+			beforeValue();
+			char buffer[32];
+			auto [end, _] = std::to_chars(buffer, buffer + sizeof(buffer), number);
+			m_out.append(buffer, end);
+			if constexpr (std::is_floating_point_v<T>) {
+				if (std::string_view(buffer, end).find_first_of(".e") == std::string_view::npos)
+					m_out += ".0";
+			}
+		}
+
+		void value(std::string_view str)
+		{
+			beforeValue();
+			writeString(str);
+		}
+
+		void value(const std::string& str) { value(std::string_view(str)); }
+		void value(const char* str) { value(std::string_view(str)); }
+
+		// for the values that only have a nlohmann::json conversion
+		void value(const nlohmann::json& json);
+
+		auto str() const -> const std::string& { return m_out; }
+		auto release() -> std::string { return std::move(m_out); }
+
+	private:
+		void begin(char bracket)
+		{
+			beforeValue();
+			m_out += bracket;
+			m_depth++;
+			m_first = true;
+		}
+
+		void end(char bracket)
+		{
+			m_depth--;
+			if (!m_first)
+				newline();
+			m_out += bracket;
+			m_first = false;
+		}
+
+		void beforeValue()
+		{
+			if (m_afterKey)
+				m_afterKey = false;
+			else if (m_depth > 0)
+				separator();
+		}
+
+		void separator()
+		{
+			if (!m_first)
+				m_out += ',';
+			m_first = false;
+			newline();
+		}
+
+		void newline()
+		{
+			if (m_indent < 0)
+				return;
+			m_out += '\n';
+			m_out.append(static_cast<std::size_t>(m_depth * m_indent), ' ');
+		}
+
+		void writeString(std::string_view str);
+
+		std::string m_out;
+		int m_indent;
+		int m_depth = 0;
+		bool m_first = true;
+		bool m_afterKey = false;
+	};
+
+	/* the read functions consume the value even if it has the wrong type, then they return false
+	 * failed() is only set for text that isn't json, everything after that returns false
+	*/
+	class JsonReader {
+	public:
+		explicit JsonReader(std::string_view text) : m_text(text) {}
+
+		bool beginObject() { return expect('{'); }
+
+		// the key of the next member, false after the last one
+		// 'key' may point in the reader, it's valid until the next key
+		bool nextKey(std::string_view& key)
+		{
+			if (!nextMember('}'))
+				return false;
+			key = parseString(m_key);
+			skipSpace();
+			return expect(':');
+		}
+
+		bool beginArray() { return expect('['); }
+
+		// false after the last element
+		bool nextElement() { return nextMember(']'); }
+
+		bool read(bool& b);
+
+		template <typename T>
+		requires (std::is_arithmetic_v<T> && !std::is_same_v<T, bool>)
+		bool read(T& number)
+		{
+			auto text = scanNumber();
+			if (text.empty())
+				return false;
+			if constexpr (std::is_integral_v<T>) {
+				// a float written in an int property
+				if (text.find_first_of(".eE") != std::string_view::npos) {
+					double d;
+					if (!parseNumber(text, d))
+						return false;
+					number = static_cast<T>(d);
+					return true;
+				}
+			}
+			return parseNumber(text, number);
+		}
+
+		bool read(std::string& str);
+
+		// the text of the value
+		auto skipValue() -> std::string_view;
+
+		// the first character of the next value, '\0' at the end
+		auto peek() -> char
+		{
+			skipSpace();
+			return m_pos < m_text.size() ? m_text[m_pos] : '\0';
+		}
+
+		bool failed() const { return m_failed; }
+		auto position() const -> std::size_t { return m_pos; }
+
+	private:
+		bool nextMember(char close);
+		bool expect(char c);
+		auto parseString(std::string& scratch) -> std::string_view;
+		auto scanNumber() -> std::string_view;
+
+		template <typename T>
+		bool parseNumber(std::string_view text, T& number)
+		{
+			auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), number);
+			return error == std::errc{} && end == text.data() + text.size();
+		}
+
+		bool fail()
+		{
+			m_failed = true;
+			return false;
+		}
+
+		void skipSpace()
+		{
+			while (m_pos < m_text.size() && (m_text[m_pos] == ' ' || m_text[m_pos] == '\n' || m_text[m_pos] == '\r' || m_text[m_pos] == '\t'))
+				m_pos++;
+		}
+
+		std::string_view m_text;
+		std::size_t m_pos = 0;
+		bool m_failed = false;
+		std::string m_key; // the unescaped key, when it has escapes
+		std::string m_string;
+	};
+
+	struct JsonProperty {
+		const char* name;
+		void (*write)(JsonWriter&, const void* obj) = nullptr;
+		// false if the value is missing or has the wrong type, the property keeps its value
+		bool (*read)(JsonReader&, Entity&, void* obj) = nullptr;
+		// read() in two steps: parse() makes a new value starting from the property of 'defaults' and runs no setter
+		// of the object, apply() moves the value in the object with the setter, destroy() frees the value
+		void* (*parse)(JsonReader&, const void* defaults) = nullptr;
+		void (*apply)(void* value, void* obj) = nullptr;
+		void (*destroy)(void* value) = nullptr;
+	};
+
+	struct JsonType;
+
+	/* the property values of an object parsed by JsonType::parseObject, not set on any object yet
+	 * a buffer of typed values, one for every property found in the json
+	*/
+	class JsonValues {
+	public:
+		JsonValues() = default;
+		~JsonValues() { clear(); }
+
+		JsonValues(JsonValues&& other) noexcept
+			: m_type(other.m_type), m_values(std::move(other.m_values)), m_read(other.m_read), m_failed(other.m_failed)
+		{
+			other.m_values.clear();
+		}
+
+		JsonValues& operator=(JsonValues&& other) noexcept
+		{
+			if (this != &other) {
+				clear();
+				m_type = other.m_type;
+				m_values = std::move(other.m_values);
+				m_read = other.m_read;
+				m_failed = other.m_failed;
+				other.m_values.clear();
+			}
+			return *this;
+		}
+
+		void clear();
+
+	private:
+		friend struct JsonType;
+
+		const JsonType* m_type = nullptr;
+		std::vector<std::pair<std::uint32_t, void*>> m_values; // index in props, value
+		std::uint64_t m_read = 0;
+		bool m_failed = false;
+	};
+
+	// the json service of a type, see jsonType<T>()
+	struct JsonType {
+		const meta::Metadata* metadata;
+		std::vector<JsonProperty> props;
+		std::vector<std::uint32_t> byName; // indices in props, sorted by name
+		// a default constructed object, the start values of parse(); nullptr if the type isn't default constructible
+		void* (*construct)() = nullptr;
+		void (*destroy)(void* obj) = nullptr;
+
+		auto find(std::string_view name, std::size_t hint) const -> std::size_t;
+
+		void writeObject(JsonWriter& writer, const void* obj) const;
+		// logs the properties missing from the object
+		bool readObject(JsonReader& reader, Entity& entity, void* obj) const;
+
+		bool canParse() const { return construct != nullptr; }
+
+		/* readObject() split in two: parseObject() reads the values without an object, so it can run on any thread
+		 * (the setters of the nested value types run, on the values), applyObject() sets them with the setters
+		 * of the properties, where the setters can run (they may load resources)
+		*/
+		bool parseObject(JsonReader& reader, JsonValues& values) const;
+		// logs the properties missing from the object, like readObject()
+		void applyObject(JsonValues& values, Entity& entity, void* obj) const;
+
+	private:
+		void logMissing(std::uint64_t read, const Entity& entity) const;
+	};
+
+	// built on the first call, sMembers<T> may not be initialized yet when the services are registered
+	using JsonTypeGetter = const JsonType& (*)();
+
+	// the json service, or nullptr if the type only has the nlohmann::json functions (serviceSerializeName)
+	inline auto jsonTypeOf(const meta::Metadata& mdata) -> const JsonType*
+	{
+		auto json = mdata.data<JsonTypeGetter>(serviceJsonName);
+		return json ? &(*json)() : nullptr;
+	}
+
+	template <typename T>
+	const JsonType& jsonType();
+
+	namespace detail {
+
+		template <typename T, template <typename...> class Template>
+		constexpr bool isInstanceOf = false;
+		template <typename... Args, template <typename...> class Template>
+		constexpr bool isInstanceOf<Template<Args...>, Template> = true;
+
+		// calls onKey(key) for every member, onKey reads the value and returns true or returns false for the unknown keys
+		template <typename F>
+		bool readJsonMembers(JsonReader& reader, F&& onKey)
+		{
+			if (!reader.beginObject())
+				return false;
+			std::string_view key;
+			while (reader.nextKey(key))
+				if (!onKey(key))
+					reader.skipValue();
+			return !reader.failed();
+		}
+	}
+
+	template <typename T>
+	void writeJsonValue(JsonWriter& writer, const T& value)
+	{
+		if constexpr (meta::isRegistered<T>())
+			jsonType<T>().writeObject(writer, &value);
+		else if constexpr (std::is_enum_v<T>)
+			writer.value(meta::getNameOfEnumValue<T>(value));
+		else if constexpr (std::is_same_v<T, char>)
+			writer.value(std::string_view(&value, 1));
+		else if constexpr (std::is_arithmetic_v<T> || std::is_same_v<T, std::string>)
+			writer.value(value);
+		else if constexpr (std::is_same_v<T, sf::Time>)
+			writer.value(value.asSeconds());
+		else if constexpr (detail::isInstanceOf<T, sf::Vector2>) {
+			writer.beginObject();
+			writer.key("x"); writer.value(value.x);
+			writer.key("y"); writer.value(value.y);
+			writer.endObject();
+		}
+		else if constexpr (std::is_same_v<T, sf::Color>) {
+			writer.beginObject();
+			writer.key("r"); writer.value(value.r);
+			writer.key("g"); writer.value(value.g);
+			writer.key("b"); writer.value(value.b);
+			writer.key("a"); writer.value(value.a);
+			writer.endObject();
+		}
+		else if constexpr (detail::isInstanceOf<T, std::vector>) {
+			writer.beginArray();
+			for (const auto& element : value)
+				writeJsonValue<typename T::value_type>(writer, element);
+			writer.endArray();
+		}
+		else /* convertible to json */
+			writer.value(nlohmann::json(value));
+	}
+
+	template <typename T>
+	bool readJsonValue(JsonReader& reader, Entity& entity, T& value)
+	{
+		if constexpr (meta::isRegistered<T>())
+			return jsonType<T>().readObject(reader, entity, &value);
+		else if constexpr (std::is_enum_v<T>) {
+			std::string name;
+			if (!reader.read(name))
+				return false;
+			if (const auto* fields = meta::getEnumValues<T>())
+				for (const auto& field : *fields)
+					if (field.name == name) {
+						value = static_cast<T>(field.value);
+						return true;
+					}
+			return false;
+		}
+		else if constexpr (std::is_same_v<T, char>) {
+			std::string str;
+			if (!reader.read(str) || str.empty())
+				return false;
+			value = str[0];
+			return true;
+		}
+		else if constexpr (std::is_arithmetic_v<T> || std::is_same_v<T, std::string>)
+			return reader.read(value);
+		else if constexpr (std::is_same_v<T, sf::Time>) {
+			float seconds;
+			if (!reader.read(seconds))
+				return false;
+			value = sf::seconds(seconds);
+			return true;
+		}
+		else if constexpr (detail::isInstanceOf<T, sf::Vector2>) {
+			int found = 0;
+			bool ok = detail::readJsonMembers(reader, [&](std::string_view key) {
+				if (key == "x") found += reader.read(value.x);
+				else if (key == "y") found += reader.read(value.y);
+				else return false;
+				return true;
+			});
+			return ok && found == 2;
+		}
+		else if constexpr (std::is_same_v<T, sf::Color>) {
+			int found = 0;
+			bool ok = detail::readJsonMembers(reader, [&](std::string_view key) {
+				if (key == "r") found += reader.read(value.r);
+				else if (key == "g") found += reader.read(value.g);
+				else if (key == "b") found += reader.read(value.b);
+				else if (key == "a") found += reader.read(value.a);
+				else return false;
+				return true;
+			});
+			return ok && found == 4;
+		}
+		else if constexpr (detail::isInstanceOf<T, std::vector>) {
+			if (!reader.beginArray())
+				return false;
+			value.clear();
+			bool ok = true;
+			while (reader.nextElement()) {
+				typename T::value_type element{};
+				ok &= readJsonValue(reader, entity, element);
+				value.push_back(std::move(element));
+			}
+			return ok && !reader.failed();
+		}
+		else /* convertible from json */ {
+			auto text = reader.skipValue();
+			auto json = nlohmann::json::parse(text, nullptr, false);
+			if (reader.failed() || json.is_discarded())
+				return false;
+			value = json.template get<T>();
+			return true;
+		}
+	}
+
+	namespace detail {
+
+		template <typename T, std::size_t I>
+		void addJsonProperty(JsonType& type)
+		{
+			const auto& member = std::get<I>(meta::detail::sMembers<T>);
+			if constexpr (std::decay_t<decltype(member)>::isProperty) {
+				using PropType = meta::get_member_type<decltype(member)>;
+				JsonProperty prop{ .name = member.getName() };
+				prop.write = [](JsonWriter& writer, const void* obj) {
+					const auto& member = std::get<I>(meta::detail::sMembers<T>);
+					writeJsonValue<PropType>(writer, member.getCopy(*static_cast<const T*>(obj)));
+				};
+				prop.read = [](JsonReader& reader, Entity& entity, void* obj) {
+					const auto& member = std::get<I>(meta::detail::sMembers<T>);
+					auto& value = *static_cast<T*>(obj);
+					PropType propValue = member.getCopy(value);
+					if (!readJsonValue(reader, entity, propValue))
+						return false;
+					member.set(value, std::move(propValue));
+					return true;
+				};
+				prop.parse = [](JsonReader& reader, const void* defaults) -> void* {
+					const auto& member = std::get<I>(meta::detail::sMembers<T>);
+					auto* value = new PropType(member.getCopy(*static_cast<const T*>(defaults)));
+					// only the nested types log with it, the entity doesn't exist yet
+					Entity entity;
+					if (!readJsonValue(reader, entity, *value)) {
+						delete value;
+						return nullptr;
+					}
+					return value;
+				};
+				prop.apply = [](void* value, void* obj) {
+					const auto& member = std::get<I>(meta::detail::sMembers<T>);
+					member.set(*static_cast<T*>(obj), std::move(*static_cast<PropType*>(value)));
+				};
+				prop.destroy = [](void* value) {
+					delete static_cast<PropType*>(value);
+				};
+				type.props.push_back(prop);
+			}
+		}
+	}
+
+	/* the properties of T with their read/write functions and the name table, built once
+	 * addSerdeFunctions puts &jsonType<T> in the Metadata of T (serviceJsonName)
+	*/
+	template <typename T>
+	const JsonType& jsonType()
+	{
+		static const JsonType type = [] {
+			JsonType type{ meta::type<T>() };
+			if constexpr (std::is_default_constructible_v<T>) {
+				type.construct = []() -> void* { return new T(); };
+				type.destroy = [](void* obj) { delete static_cast<T*>(obj); };
+			}
+			constexpr auto count = std::tuple_size_v<std::decay_t<decltype(meta::detail::sMembers<T>)>>;
+			[&]<std::size_t... Is>(std::index_sequence<Is...>) {
+				(detail::addJsonProperty<T, Is>(type), ...);
+			}(std::make_index_sequence<count>{});
+
+			type.byName.resize(type.props.size());
+			for (std::uint32_t i = 0; i < type.byName.size(); i++)
+				type.byName[i] = i;
+			std::sort(type.byName.begin(), type.byName.end(), [&type](auto a, auto b) {
+				return std::string_view(type.props[a].name) < std::string_view(type.props[b].name);
+			});
+			return type;
+		}();
+		return type;
+	}
+}
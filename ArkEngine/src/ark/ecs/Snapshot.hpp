@@ -0,0 +1,314 @@
+#pragma once
+
+#include <memory>
+#include <new>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+
+#include "ark/ecs/EntityManager.hpp"
+#include "ark/ecs/SerdeJsonDirector.hpp"
+
+namespace ark {
+
+	/* Copia unei lumi intregi, intr-un singur buffer (EntityManager::snapshot() si restore())
+	 *
+	 * buffer: [ masks ][ free entities ][ per tip de componenta: entity ids, apoi componentele ] ...
+	 * componentele trivially copyable sunt copiate cu memcpy, celelalte cu copy constructor-ul din meta,
+	 * iar cele fara copy constructor prin serviciile serialize/deserialize (json in CBOR), ex. ScriptingComponent.
+	 * Tipurile care nu au nimic din astea nu sunt salvate, snapshot() da un warning.
+	 *
+	 * E pentru procesul curent: quick-save in memorie, rollback, fixture-uri pentru teste.
+	 * Component id-urile si copiile facute cu copy constructor n-au sens in alt proces, nu-l scrie pe disc.
+	 * Acelasi snapshot poate fi restaurat de mai multe ori.
+	*/
+	class Snapshot final {
+	public:
+		// alinierea maxima a componentelor copiate cu copy constructor
+		static constexpr std::size_t Align = 64;
+
+		Snapshot() = default;
+		Snapshot(const Snapshot&) = delete;
+		Snapshot& operator=(const Snapshot&) = delete;
+
+		Snapshot(Snapshot&& other) noexcept
+			: m_buffer(std::move(other.m_buffer)),
+			m_sections(std::exchange(other.m_sections, {})),
+			m_size(std::exchange(other.m_size, 0)),
+			m_entityCount(std::exchange(other.m_entityCount, 0)),
+			m_freeCount(std::exchange(other.m_freeCount, 0)),
+			m_masks(other.m_masks),
+			m_free(other.m_free)
+		{}
+
+		Snapshot& operator=(Snapshot&& other) noexcept
+		{
+			if (&other != this) {
+				destroyComponents();
+				m_buffer = std::move(other.m_buffer);
+				m_sections = std::exchange(other.m_sections, {});
+				m_size = std::exchange(other.m_size, 0);
+				m_entityCount = std::exchange(other.m_entityCount, 0);
+				m_freeCount = std::exchange(other.m_freeCount, 0);
+				m_masks = other.m_masks;
+				m_free = other.m_free;
+			}
+			return *this;
+		}
+
+		~Snapshot() { destroyComponents(); }
+
+		bool empty() const { return !m_buffer; }
+
+		// bytes
+		std::size_t size() const { return m_size; }
+
+		// live and free entities
+		std::size_t entityCount() const { return m_entityCount; }
+
+	private:
+		friend class EntityManager;
+
+		enum class Copy { Memcpy, CopyConstructor, Serialized };
+
+		struct Section {
+			int compId;
+			const meta::Metadata* metadata;
+			Copy copy;
+			std::size_t count;
+			std::size_t entities; // offset: EntityId[count], sorted
+			std::size_t components; // offset: components[count] or, if serialized, [u32 size][cbor] per component
+		};
+
+		struct Deleter {
+			void operator()(std::byte* p) const { ::operator delete(p, std::align_val_t{ Align }); }
+		};
+
+		void destroyComponents()
+		{
+			for (const auto& section : m_sections) {
+				if (section.copy != Copy::CopyConstructor || !section.metadata->destructor)
+					continue;
+				for (std::size_t i = 0; i < section.count; i++)
+					section.metadata->destructor(at(section.components + i * section.metadata->size));
+			}
+			m_sections.clear();
+		}
+
+		std::byte* at(std::size_t offset) const { return m_buffer.get() + offset; }
+
+		std::unique_ptr<std::byte[], Deleter> m_buffer;
+		std::vector<Section> m_sections;
+		std::size_t m_size = 0;
+		std::size_t m_entityCount = 0;
+		std::size_t m_freeCount = 0;
+		std::size_t m_masks = 0; // offset: ComponentMask[m_entityCount]
+		std::size_t m_free = 0; // offset: EntityId[m_freeCount]
+	};
+
+	inline auto EntityManager::snapshot() const -> Snapshot
+	{
+		static_assert(std::is_trivially_copyable_v<ComponentMask>);
+		using Copy = Snapshot::Copy;
+		using nlohmann::json;
+
+		Snapshot snap;
+		snap.m_entityCount = m_masks.size();
+		snap.m_freeCount = m_freeEntities.size();
+
+		std::array<std::vector<EntityId>, MaxComponentTypes> entities;
+		for (EntityId id = 0; id < static_cast<EntityId>(m_masks.size()); id++) {
+			if (m_isFree[id])
+				continue;
+			const auto mask = m_masks[id];
+			for (int compId = 0; compId < MaxComponentTypes; compId++)
+				if (mask.test(compId))
+					entities[compId].push_back(id);
+		}
+
+		std::size_t size = 0;
+		auto reserve = [&size](std::size_t bytes, std::size_t align) {
+			size = (size + align - 1) / align * align;
+			auto offset = size;
+			size += bytes;
+			return offset;
+		};
+		snap.m_masks = reserve(sizeof(ComponentMask) * snap.m_entityCount, alignof(ComponentMask));
+		snap.m_free = reserve(sizeof(EntityId) * snap.m_freeCount, alignof(EntityId));
+
+		ComponentMask skipped;
+		std::vector<std::vector<std::uint8_t>> serialized; // in the order of the serialized components
+		for (int compId = 0; compId < MaxComponentTypes; compId++) {
+			const auto& ids = entities[compId];
+			if (ids.empty())
+				continue;
+			const auto* mdata = m_metadata[compId];
+			Snapshot::Section section{ .compId = compId, .metadata = mdata, .count = ids.size() };
+
+			auto serialize = mdata->func<json(const void*)>(serde::serviceSerializeName);
+			auto deserialize = mdata->func<void(Entity&, const json&, void*)>(serde::serviceDeserializeName);
+			if (mdata->trivially_copyable)
+				section.copy = Copy::Memcpy;
+			else if (mdata->copy_constructor && mdata->align <= Snapshot::Align)
+				section.copy = Copy::CopyConstructor;
+			else if (serialize && deserialize && mdata->default_constructor)
+				section.copy = Copy::Serialized;
+			else {
+				EngineLog(LogSource::EntityM, LogLevel::Warning,
+					"snapshot: component (%s) can't be copied nor serialized, it's left out", mdata->name);
+				skipped.set(compId);
+				continue;
+			}
+
+			section.entities = reserve(sizeof(EntityId) * ids.size(), alignof(EntityId));
+			if (section.copy == Copy::Serialized) {
+				std::size_t bytes = 0;
+				for (auto id : ids) {
+					serialized.push_back(json::to_cbor(serialize(component(id, compId))));
+					bytes += sizeof(std::uint32_t) + serialized.back().size();
+				}
+				section.components = reserve(bytes, alignof(std::uint32_t));
+			}
+			else
+				section.components = reserve(mdata->size * ids.size(), mdata->align);
+			snap.m_sections.push_back(section);
+		}
+
+		snap.m_buffer.reset(static_cast<std::byte*>(::operator new(std::max<std::size_t>(size, 1), std::align_val_t{ Snapshot::Align })));
+		snap.m_size = size;
+
+		auto* masks = reinterpret_cast<ComponentMask*>(snap.at(snap.m_masks));
+		std::copy(m_masks.begin(), m_masks.end(), masks);
+		if (skipped.any())
+			for (std::size_t id = 0; id < snap.m_entityCount; id++)
+				masks[id] &= ~skipped;
+		std::copy(m_freeEntities.begin(), m_freeEntities.end(), reinterpret_cast<EntityId*>(snap.at(snap.m_free)));
+
+		auto nextSerialized = serialized.begin();
+		for (const auto& section : snap.m_sections) {
+			const auto& ids = entities[section.compId];
+			const auto* mdata = section.metadata;
+			std::memcpy(snap.at(section.entities), ids.data(), sizeof(EntityId) * ids.size());
+
+			auto* dst = snap.at(section.components);
+			for (auto id : ids) {
+				const void* src = component(id, section.compId);
+				switch (section.copy) {
+				case Copy::Memcpy:
+					std::memcpy(dst, src, mdata->size);
+					dst += mdata->size;
+					break;
+				case Copy::CopyConstructor:
+					mdata->copy_constructor(dst, src);
+					dst += mdata->size;
+					break;
+				case Copy::Serialized: {
+					auto bytes = static_cast<std::uint32_t>(nextSerialized->size());
+					std::memcpy(dst, &bytes, sizeof(bytes));
+					std::memcpy(dst + sizeof(bytes), nextSerialized->data(), bytes);
+					dst += sizeof(bytes) + bytes;
+					++nextSerialized;
+					break;
+				}
+				}
+			}
+		}
+		return snap;
+	}
+
+	inline void EntityManager::restore(const Snapshot& snap)
+	{
+		checkStructuralChange("restore");
+		using Copy = Snapshot::Copy;
+		using nlohmann::json;
+
+		if (snap.empty()) {
+			EngineLog(LogSource::EntityM, LogLevel::Error, "restore: the snapshot is empty");
+			return;
+		}
+
+		std::vector<EntityId> alive;
+		for (EntityId id = 0; id < static_cast<EntityId>(m_masks.size()); id++)
+			if (!m_isFree[id])
+				alive.push_back(id);
+		implDestroyEntities(alive);
+
+		const auto* masks = reinterpret_cast<const ComponentMask*>(snap.at(snap.m_masks));
+		m_masks.assign(masks, masks + snap.m_entityCount);
+		const auto* freeEntities = reinterpret_cast<const EntityId*>(snap.at(snap.m_free));
+		m_freeEntities.assign(freeEntities, freeEntities + snap.m_freeCount);
+		m_isFree.assign(snap.m_entityCount, false);
+		for (auto id : m_freeEntities)
+			m_isFree[id] = true;
+
+		alive.clear();
+		for (EntityId id = 0; id < static_cast<EntityId>(m_masks.size()); id++)
+			if (!m_isFree[id])
+				alive.push_back(id);
+
+		const auto tick = changeTick();
+		for (const auto& section : snap.m_sections)
+			if (!m_metadata[section.compId])
+				registerComponentId(section.compId, section.metadata->type);
+		if (m_archetypes) {
+			for (const auto& section : snap.m_sections)
+				m_archetypes->setMetadata(section.compId, *section.metadata);
+			for (auto id : alive)
+				if (m_masks[id].any())
+					m_archetypes->insert(id, m_masks[id], tick);
+		}
+
+		for (const auto& section : snap.m_sections) {
+			const int compId = section.compId;
+			const auto* mdata = section.metadata;
+			const std::span<const EntityId> ids(reinterpret_cast<const EntityId*>(snap.at(section.entities)), section.count);
+			if (!m_archetypes)
+				pool(compId, mdata->type).reserve(ids.size(), ids.back());
+
+			const auto* src = snap.at(section.components);
+			for (auto id : ids) {
+				void* dst = m_archetypes ? m_archetypes->get(id, compId) : m_pools[compId]->emplace(id, tick);
+				switch (section.copy) {
+				case Copy::Memcpy:
+					std::memcpy(dst, src, mdata->size);
+					src += mdata->size;
+					break;
+				case Copy::CopyConstructor:
+					mdata->copy_constructor(dst, src);
+					src += mdata->size;
+					break;
+				case Copy::Serialized:
+					mdata->default_constructor(dst); // deserialized after onAdd, like serde::deserializeEntity
+					break;
+				}
+			}
+		}
+
+		// semnalele dupa ce toate componentele exista, ca la createEntities
+		if (m_signalCreate.size())
+			for (auto id : alive)
+				m_signalCreate.publish(*this, Entity{ id, this });
+		m_signalCreateBatch.publish(*this, alive);
+		for (const auto& section : snap.m_sections)
+			publishAddBulk(section.compId, section.metadata->type,
+				std::span<const EntityId>(reinterpret_cast<const EntityId*>(snap.at(section.entities)), section.count));
+
+		for (const auto& section : snap.m_sections) {
+			if (section.copy != Copy::Serialized)
+				continue;
+			auto deserialize = section.metadata->func<void(Entity&, const json&, void*)>(serde::serviceDeserializeName);
+			const auto* ids = reinterpret_cast<const EntityId*>(snap.at(section.entities));
+			const auto* src = snap.at(section.components);
+			for (std::size_t i = 0; i < section.count; i++) {
+				std::uint32_t bytes;
+				std::memcpy(&bytes, src, sizeof(bytes));
+				const auto* cbor = reinterpret_cast<const std::uint8_t*>(src + sizeof(bytes));
+				Entity entity{ ids[i], this };
+				// onAdd may have destroyed it
+				if (void* dst = tryComponent(ids[i], section.compId))
+					deserialize(entity, json::from_cbor(cbor, cbor + bytes), dst);
+				src += sizeof(bytes) + bytes;
+			}
+		}
+	}
+}
@@ -8,7 +8,9 @@
 
 #include "ark/core/Message.hpp"
 #include "ark/core/MessageBus.hpp"
+#include "ark/core/JobSystem.hpp"
 #include "ark/ecs/Entity.hpp"
+#include "ark/ecs/CommandBuffer.hpp"
 #include "ark/ecs/Component.hpp"
 #include "ark/ecs/Meta.hpp"
 #include "ark/ecs/Querry.hpp"
@@ -27,15 +29,62 @@ namespace ark
 		virtual void init() {}
 		virtual void update() = 0;
 		virtual void handleEvent(sf::Event) {}
+		// every message on the bus, only for the systems that override it; subscribeMessage<T> gets just the type T
 		virtual void handleMessage(const Message&) {}
 
 		bool isActive() { return active; }
+		bool wantsBroadcast() const { return broadcast; }
+
+		/* what update() touches, used by SystemManager to run systems in parallel
+		 * a system that declared nothing conflicts with every other system and runs on the main thread
+		*/
+		struct Access {
+			ComponentMask reads;
+			ComponentMask writes;
+			bool declared = false;
+			bool mainThreadOnly = false; // for systems that use SFML/ImGui/the window in update()
+		};
+
+		auto getAccess() const -> const Access& { return access; }
 
 		const std::string name;
 		const std::type_index type;
 
 	protected:
 
+		/* declares the components used in update(): const components are read, the others are written
+		 * once declared, update() can run on a worker thread at the same time as systems it doesn't conflict with,
+		 * so it must not create/destroy entities or add/remove components directly,
+		 * structural changes are recorded in 'commands' and applied after SystemManager::update
+		 * postMessage can be used from any thread, see MessageBus
+		 * Without<T> only tests the entity's mask, it doesn't access T
+		*/
+		template <ConceptViewTerm... Cs>
+		void declareAccess()
+		{
+			(declareTerm<Cs>(), ...);
+			access.declared = true;
+			onAccessChanged();
+		}
+
+		/* view = declareView<const Transform, MousePickUpComponent>(); same as declareAccess + entityManager.view
+		 * Changed/Added terms yield the components changed/added since the previous update of this system
+		*/
+		template <ConceptViewTerm... Cs>
+		auto declareView() -> View<Cs...>
+		{
+			declareAccess<Cs...>();
+			View<Cs...> view(*mEntityManager);
+			view.setSince(&lastRunTick);
+			return view;
+		}
+
+		void setMainThreadOnly(bool mainThread = true)
+		{
+			access.mainThreadOnly = mainThread;
+			onAccessChanged();
+		}
+
 		template <typename T>
 		requires std::is_aggregate_v<T>
 		T* postMessage(T&& value = T{})
@@ -49,8 +98,18 @@ namespace ark
 			return messageBus->post<T>(std::forward<Args>(args)...);
 		}
 
+		/* handler(payload..., const T&) is called only for the messages of type T, from init() or later
+		 * subscribeMessage<MessagePickUp>(&ChessSystem::onPickUp, this); the subscription ends with the system
+		*/
+		template <typename T, typename F, typename... Payload>
+		void subscribeMessage(F&& handler, Payload&&... payload)
+		{
+			subscriptions.emplace_back(messageBus->subscribe<T>(std::forward<F>(handler), std::forward<Payload>(payload)...));
+		}
+
 		EntityManager& getEntityManager() const { return *mEntityManager; }
 		SystemManager& getSystemManager() const { return *mSystemManager; }
+		CommandBuffer& getCommands() const;
 
 		__declspec(property(get=getEntityManager)) 
 			EntityManager entityManager;
@@ -58,12 +117,29 @@ namespace ark
 		__declspec(property(get=getSystemManager)) 
 			SystemManager systemManager;
 
+		// played back after every SystemManager::update
+		__declspec(property(get=getCommands)) 
+			CommandBuffer commands;
+
 	private:
 		friend class SystemManager;
 		EntityManager* mEntityManager = nullptr;
 		MessageBus* messageBus = nullptr;
+		std::vector<ScopedConnection> subscriptions;
 		SystemManager* mSystemManager = nullptr;
 		bool active = true;
+		bool broadcast = false; // overrides handleMessage, set by SystemManager::addSystem
+		Access access;
+		ChangeTick lastRunTick = 0; // the change tick of the previous update, set by SystemManager
+
+		void onAccessChanged();
+
+		template <typename C>
+		void declareTerm()
+		{
+			if constexpr (view_term_kind_v<C> != ViewTermKind::Excluded)
+				(std::is_const_v<view_component_t<C>> ? access.reads : access.writes).set(mEntityManager->idFromType<view_component_t<C>>());
+		}
 	};
 
 	template <typename T>
@@ -77,7 +153,7 @@ namespace ark
 	class SystemManager {
 
 	public:
-		SystemManager(MessageBus& bus, EntityManager& manager) : messageBus(bus), registry(manager) {}
+		SystemManager(MessageBus& bus, EntityManager& manager) : messageBus(bus), registry(manager), commands(manager) {}
 		~SystemManager() = default;
 
 		template <typename T, typename...Args>
@@ -94,7 +170,12 @@ namespace ark
 			system->mEntityManager = &registry;
 			system->messageBus = &messageBus;
 			system->mSystemManager = this;
+			// &T::handleMessage has the type of the class that declares it
+			system->broadcast = !std::is_same_v<decltype(&T::handleMessage), void (System::*)(const Message&)>;
+			if (system->broadcast)
+				broadcastSystems.push_back(system);
 			system->init();
+			scheduleDirty = true;
 
 			if constexpr (std::is_base_of_v<Renderer, T>)
 				renderers.push_back(dynamic_cast<T*>(system));
@@ -144,9 +225,12 @@ namespace ark
 			if (std::is_base_of_v<Renderer, T>)
 				std::erase(renderers, getSystem<T>());
 			if (auto system = getSystem<T>(); system) {
+				std::erase(activeSystems, system);
+				std::erase(broadcastSystems, system);
 				std::erase_if(systems, [system](auto& sys) {
 					return sys.get() == system;
 				});
+				scheduleDirty = true;
 			}
 		}
 
@@ -171,11 +255,16 @@ namespace ark
 
 			if (isCurrentlyActive && !active) {
 				std::erase(activeSystems, system);
+				std::erase(broadcastSystems, system);
 				system->active = false;
+				scheduleDirty = true;
 			}
 			else if (!isCurrentlyActive && active) {
 				activeSystems.push_back(system);
+				if (system->broadcast)
+					broadcastSystems.push_back(system);
 				system->active = true;
+				scheduleDirty = true;
 			}
 
 			if (std::is_base_of_v<Renderer, T>) {
@@ -196,20 +285,39 @@ namespace ark
 			});
 		}
 
+		// only the active systems that override System::handleMessage, the others get their types from subscribeMessage
 		void handleMessage(const Message& message)
 		{
-			forEachSystem([&message](System* system) {
+			for (auto* system : broadcastSystems)
 				system->handleMessage(message);
-			});
 		}
 
+		/* with parallel update on, systems that declared their access run on JobSystem::global() as soon as
+		 * every earlier system they conflict with has finished (writes vs reads/writes of the same component)
+		 * the order between conflicting systems is the order in which they were added
+		*/
 		void update() 
 		{
-			forEachSystem([](System* system) {
-				system->update();
-			});
+			if (!parallelUpdate) {
+				forEachSystem([this](System* system) {
+					system->update();
+					system->lastRunTick = registry.advanceChangeTick();
+				});
+			}
+			else {
+				if (scheduleDirty)
+					buildSchedule();
+				runSchedule();
+			}
+			commands.playback();
 		}
 
+		void setParallelUpdate(bool parallel) { parallelUpdate = parallel; }
+		bool isParallelUpdate() const { return parallelUpdate; }
+
+		// deferred structural changes, applied at the end of update()
+		CommandBuffer& getCommands() { return commands; }
+
 		void preRender(sf::RenderTarget& target)
 		{
 			for (auto renderer : renderers)
@@ -226,11 +334,130 @@ namespace ark
 				renderer->postRender(target);
 		}
 
+	private:
+		static bool conflicts(const System::Access& a, const System::Access& b)
+		{
+			if (!a.declared || !b.declared)
+				return true;
+			return (a.writes & (b.reads | b.writes)).any() || (b.writes & a.reads).any();
+		}
+
+		// DAG peste activeSystems: muchie i -> j daca i < j si se suprapun
+		void buildSchedule()
+		{
+			const auto count = activeSystems.size();
+			schedule.assign(count, {});
+			for (std::size_t j = 0; j < count; j++) {
+				for (std::size_t i = 0; i < j; i++) {
+					if (conflicts(activeSystems[i]->access, activeSystems[j]->access)) {
+						schedule[i].successors.push_back(static_cast<int>(j));
+						schedule[j].predecessors++;
+					}
+				}
+			}
+			scheduleDirty = false;
+		}
+
+		struct ScheduleNode {
+			std::vector<int> successors;
+			int predecessors = 0;
+		};
+
+		// state of one update, shared by the jobs
+		struct ScheduleRun {
+			SystemManager* manager;
+			std::unique_ptr<std::atomic<int>[]> remaining;
+			std::atomic<std::size_t> finished = 0;
+			JobSystem::Counter jobs = 0;
+			std::mutex mainMutex;
+			std::vector<int> mainReady; // systems that wait for the main thread
+		};
+
+		void runSchedule()
+		{
+			const auto count = activeSystems.size();
+			ScheduleRun run{ this, std::make_unique<std::atomic<int>[]>(count) };
+			for (std::size_t i = 0; i < count; i++)
+				run.remaining[i] = schedule[i].predecessors;
+			for (std::size_t i = 0; i < count; i++)
+				if (schedule[i].predecessors == 0)
+					launch(run, static_cast<int>(i));
+
+			auto& jobSystem = JobSystem::global();
+			while (run.finished.load(std::memory_order_acquire) != count) {
+				int mainSystem = ArkInvalidIndex;
+				{
+					std::scoped_lock lock(run.mainMutex);
+					if (!run.mainReady.empty()) {
+						mainSystem = run.mainReady.back();
+						run.mainReady.pop_back();
+					}
+				}
+				if (mainSystem != ArkInvalidIndex)
+					execute(run, mainSystem);
+				else if (!jobSystem.tryRunJob())
+					std::this_thread::yield();
+			}
+			jobSystem.wait(run.jobs);
+		}
+
+		void launch(ScheduleRun& run, int index)
+		{
+			const auto& access = activeSystems[index]->access;
+			if (!access.declared || access.mainThreadOnly) {
+				std::scoped_lock lock(run.mainMutex);
+				run.mainReady.push_back(index);
+			}
+			else {
+				JobSystem::global().push([](const void* context, std::size_t index, std::size_t) {
+					auto& run = *static_cast<ScheduleRun*>(const_cast<void*>(context));
+					run.manager->execute(run, static_cast<int>(index));
+				}, &run, index, index + 1, run.jobs);
+			}
+		}
+
+		void execute(ScheduleRun& run, int index)
+		{
+			System* system = activeSystems[index];
+			if (system->access.declared) {
+				// sistemele declarate pot rula in paralel, deci nu au voie sa schimbe structura
+				EntityManager::StructureLock lock{ &registry };
+				system->update();
+			}
+			else
+				system->update();
+			system->lastRunTick = registry.advanceChangeTick();
+
+			for (int next : schedule[index].successors)
+				if (run.remaining[next].fetch_sub(1, std::memory_order_acq_rel) == 1)
+					launch(run, next);
+			run.finished.fetch_add(1, std::memory_order_release);
+		}
+
 	private:
 		std::vector<std::unique_ptr<System>> systems;
 		std::vector<Renderer*> renderers;
 		std::vector<System*> activeSystems;
+		std::vector<System*> broadcastSystems; // the active ones that override handleMessage
 		MessageBus& messageBus;
 		EntityManager& registry;
+		CommandBuffer commands;
+
+		bool parallelUpdate = true;
+		bool scheduleDirty = true;
+		std::vector<ScheduleNode> schedule; // index = index in activeSystems
+
+		friend class System;
 	};
+
+	inline CommandBuffer& System::getCommands() const
+	{
+		return mSystemManager->getCommands();
+	}
+
+	inline void System::onAccessChanged()
+	{
+		if (mSystemManager)
+			mSystemManager->scheduleDirty = true;
+	}
 }
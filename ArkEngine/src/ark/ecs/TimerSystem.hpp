@@ -0,0 +1,73 @@
+#pragma once
+
+#include <span>
+#include <concepts>
+
+#include "ark/core/Engine.hpp"
+#include "ark/core/TimerWheel.hpp"
+#include "ark/ecs/System.hpp"
+
+namespace ark {
+
+	/* timers driven by Engine::deltaTime(), on a TimerWheel
+	 *
+	 * auto* timers = systems.addSystem<TimerSystem>();
+	 * timers->after(entity, sf::seconds(5), [](ark::Entity e) { e.get<Health>().regen = true; });
+	 *
+	 * the timers bound to an entity are cancelled when the entity is destroyed, so a handle never fires
+	 * on another entity that got the same id. The callbacks run on the main thread, from update(),
+	 * they can create/destroy entities and schedule other timers.
+	*/
+	class TimerSystem final : public SystemT<TimerSystem> {
+	public:
+		explicit TimerSystem(sf::Time resolution = sf::milliseconds(1)) : wheel(resolution) {}
+
+		void init() override
+		{
+			destroyed = entityManager.onDestroyBatch().connect(&TimerSystem::onDestroy, this);
+		}
+
+		void update() override
+		{
+			wheel.advance(Engine::deltaTime());
+		}
+
+		// fun() after 'delay'
+		template <typename F>
+		requires std::invocable<std::decay_t<F>&>
+		auto after(sf::Time delay, F&& fun) -> TimerHandle
+		{
+			return wheel.schedule(delay, std::forward<F>(fun));
+		}
+
+		// fun(entity) after 'delay', unless the entity is destroyed before that
+		template <typename F>
+		requires std::invocable<std::decay_t<F>&, Entity>
+		auto after(Entity entity, sf::Time delay, F&& fun) -> TimerHandle
+		{
+			const auto id = entity.getID();
+			return wheel.schedule(delay, [this, id, fun = std::forward<F>(fun)]() mutable {
+				fun(Entity{ id, getEntityManager() });
+			}, static_cast<std::uint32_t>(id));
+		}
+
+		bool cancel(TimerHandle handle) { return wheel.cancel(handle); }
+		bool isPending(TimerHandle handle) const { return wheel.isPending(handle); }
+		auto remaining(TimerHandle handle) const -> sf::Time { return wheel.remaining(handle); }
+
+		// the timers bound to the entity
+		void cancelAll(Entity entity) { wheel.cancelGroup(static_cast<std::uint32_t>(entity.getID())); }
+
+		auto pendingCount() const -> std::size_t { return wheel.size(); }
+
+	private:
+		void onDestroy(EntityManager&, std::span<const EntityId> entities)
+		{
+			for (auto id : entities)
+				wheel.cancelGroup(static_cast<std::uint32_t>(id));
+		}
+
+		TimerWheel wheel;
+		ScopedConnection destroyed;
+	};
+}
@@ -10,6 +10,8 @@
 #include "ark/ecs/SceneInspector.hpp"
 #include "ark/ecs/Entity.hpp"
 #include "ark/ecs/EntityManager.hpp"
+#include "ark/ecs/Querry.hpp"
+#include "ark/util/TransformBatch.hpp"
 
 namespace ark
 {
@@ -55,6 +57,18 @@ namespace ark
 		mutable std::string m_name;
 	};
 
+	/* Transform cu matricea world in cache
+	 *
+	 * Setter-ele de mai jos ascund pe cele din sf::Transformable ca sa marcheze nodul si subarborele ca murdare
+	 * (prin referinta la sf::Transformable modificarile nu sunt vazute, nu o folosi pentru scriere).
+	 * getWorldTransform() recalculeaza doar nodurile murdare, din parintele din cache.
+	 *
+	 * Parintele si copiii sunt tinuti ca entity id, deci ierarhia rezista cand pool-urile muta componentele
+	 * (archetypes, EntityManager::compact). Transform::onAdd ii spune a cui entitate e, fiecare EntityManager
+	 * il conecteaza singur la onAdd<Transform> (serviceOnAddName, vezi inregistrarea de mai jos).
+	 *
+	 * Invariant: un nod murdar are tot subarborele murdar, deci marcarea se opreste la primul nod deja murdar.
+	*/
 	struct ARK_ENGINE_API Transform final : public sf::Transformable {
 
 		using sf::Transformable::Transformable;
@@ -63,23 +77,37 @@ namespace ark
 
 		Transform() = default;
 
-		// don't actually use it, copy_ctor is defined so that the compiler dosen't 
-		// scream when we instantiate deque<Transform> in the implementation
-		//Transform(const Transform& tx) {}
-		//Transform& operator=(const Transform& tx) {}
-
+		/* copies the relations too, they are entity ids so they stay right when the ids are kept (Snapshot restore)
+		 * a clone keeps only what onAdd validates: it joins the parent of the original, without its children
+		*/
+		Transform(const Transform& tx)
+			: sf::Transformable(tx),
+			m_parent(tx.m_parent),
+			m_children(tx.m_children),
+			m_depth(tx.m_depth)
+		{}
+
+		// relocation (pool moves, compact) keeps the hierarchy, the moved-from transform is left without relatives
 		Transform(Transform&& tx) noexcept
+			: sf::Transformable(tx),
+			m_manager(std::exchange(tx.m_manager, nullptr)),
+			m_entity(std::exchange(tx.m_entity, ArkInvalidID)),
+			m_parent(std::exchange(tx.m_parent, ArkInvalidID)),
+			m_children(std::move(tx.m_children)),
+			m_depth(std::exchange(tx.m_depth, 0)),
+			m_world(tx.m_world),
+			m_worldDirty(tx.m_worldDirty)
 		{
-			this->moveToThis(std::move(tx));
+			tx.m_children.clear();
 		}
 
+		// only the position/rotation/scale/origin, the transform stays in its place in the hierarchy
 		Transform& operator=(Transform&& tx) noexcept
 		{
 			if (&tx == this)
 				return *this;
-			this->removeFromParent();
-			this->orphanChildren();
-			this->moveToThis(std::move(tx));
+			sf::Transformable::operator=(tx);
+			markDirty();
 			return *this;
 		}
 
@@ -89,82 +117,223 @@ namespace ark
 			removeFromParent();
 		}
 
-		void addChild(Transform& child)
+		static void onAdd(ark::EntityManager& man, ark::EntityId entity) {
+			auto& trans = man.get<Transform>(entity);
+			trans.m_manager = &man;
+			trans.m_entity = entity;
+			if (trans.m_parent == ArkInvalidID && trans.m_children.empty())
+				return;
+			// a copy (see copy constructor)
+			std::erase_if(trans.m_children, [&](ark::EntityId child) {
+				auto* childTrans = trans.get(child);
+				return !childTrans || childTrans->m_parent != entity;
+			});
+			if (auto* parent = trans.get(trans.m_parent)) {
+				if (std::find(parent->m_children.begin(), parent->m_children.end(), entity) == parent->m_children.end())
+					parent->m_children.push_back(entity);
+			}
+			else {
+				trans.m_parent = ArkInvalidID;
+				trans.setDepth(0);
+			}
+		}
+
+		void setPosition(float x, float y) { sf::Transformable::setPosition(x, y); markDirty(); }
+		void setPosition(const sf::Vector2f& position) { sf::Transformable::setPosition(position); markDirty(); }
+		void setRotation(float angle) { sf::Transformable::setRotation(angle); markDirty(); }
+		void setScale(float factorX, float factorY) { sf::Transformable::setScale(factorX, factorY); markDirty(); }
+		void setScale(const sf::Vector2f& factors) { sf::Transformable::setScale(factors); markDirty(); }
+		void setOrigin(float x, float y) { sf::Transformable::setOrigin(x, y); markDirty(); }
+		void setOrigin(const sf::Vector2f& origin) { sf::Transformable::setOrigin(origin); markDirty(); }
+		void move(float offsetX, float offsetY) { sf::Transformable::move(offsetX, offsetY); markDirty(); }
+		void move(const sf::Vector2f& offset) { sf::Transformable::move(offset); markDirty(); }
+		void rotate(float angle) { sf::Transformable::rotate(angle); markDirty(); }
+		void scale(float factorX, float factorY) { sf::Transformable::scale(factorX, factorY); markDirty(); }
+		void scale(const sf::Vector2f& factor) { sf::Transformable::scale(factor); markDirty(); }
+
+		// redeclared so that &Transform::getPosition and &Transform::setPosition have the same class (meta::member_property)
+		const sf::Vector2f& getPosition() const { return sf::Transformable::getPosition(); }
+		float getRotation() const { return sf::Transformable::getRotation(); }
+		const sf::Vector2f& getScale() const { return sf::Transformable::getScale(); }
+		const sf::Vector2f& getOrigin() const { return sf::Transformable::getOrigin(); }
+
+		void addChild(ark::EntityId child)
 		{
-			if (&child == this)
+			if (!m_manager) {
+				EngineLog(LogSource::EntityM, LogLevel::Error, "Transform::addChild: the transform doesn't know its entity, it isn't a component of an EntityManager");
 				return;
-			if (child.m_parent == this)
+			}
+			auto* childTrans = get(child);
+			if (!childTrans || child == m_entity || childTrans->m_parent == m_entity)
 				return;
-			child.removeFromParent();
-			child.m_parent = this;
-			m_children.push_back(&child);
+			for (auto* parent = this; parent; parent = get(parent->m_parent))
+				if (parent->m_entity == child)
+					return; // child e un stramos
+			childTrans->removeFromParent();
+			childTrans->m_parent = m_entity;
+			m_children.push_back(child);
+			childTrans->setDepth(m_depth + 1);
+			childTrans->markDirty();
 		}
 
-		void removeChild(Transform& child)
+		void removeChild(ark::EntityId child)
 		{
-			if (&child == this)
+			auto* childTrans = get(child);
+			if (!childTrans || childTrans->m_parent != m_entity)
 				return;
-			child.m_parent = nullptr;
-			std::erase(m_children, &child);
+			childTrans->m_parent = ArkInvalidID;
+			std::erase(m_children, child);
+			childTrans->setDepth(0);
+			childTrans->markDirty();
 		}
 
-		const std::vector<Transform*>& getChildren() const { return m_children; }
+		auto getParent() const -> ark::EntityId { return m_parent; }
+		const std::vector<ark::EntityId>& getChildren() const { return m_children; }
+
+		// 0 for the roots, parents are less deep than their children
+		int getDepth() const { return m_depth; }
 
-		sf::Transform getWorldTransform()
+		/* getTransform() of every parent, top to bottom, then this; cached until this or a parent changes
+		 * filling the cache writes the transform (and its parents): a system that calls it, or TransformHierarchy::update,
+		 * declares Transform as written (declareAccess<ark::Transform>()), not const
+		*/
+		const sf::Transform& getWorldTransform() const
 		{
-			if (m_parent)
-				return this->getTransform() * m_parent->getWorldTransform();
-			else
-				return this->getTransform();
+			if (m_worldDirty) {
+				const auto* parent = get(m_parent);
+				m_world = parent ? parent->getWorldTransform() * this->getTransform() : this->getTransform();
+				m_worldDirty = false;
+			}
+			return m_world;
 		}
 
-		//int depth() { return m_depth; }
-
-
 	private:
+		friend class TransformHierarchy;
 
-		void removeFromParent()
+		auto get(ark::EntityId entity) const -> Transform*
 		{
-			if (m_parent)
-				m_parent->removeChild(*this);
+			if (!m_manager || !m_manager->isValid(entity))
+				return nullptr;
+			return const_cast<Transform*>(m_manager->tryGet<const Transform>(entity));
 		}
 
-		void orphanChildren()
+		void markDirty() const
 		{
+			if (m_worldDirty)
+				return;
+			m_worldDirty = true;
 			for (auto child : m_children)
-				child->m_parent = nullptr;
+				if (auto* childTrans = get(child))
+					childTrans->markDirty();
 		}
 
-		void moveToThis(Transform&& tx)
+		void setDepth(int depth)
 		{
-			this->m_parent = tx.m_parent;
-			tx.removeFromParent();
-			this->m_parent->addChild(*this);
-
-			this->m_children = std::move(tx.m_children);
+			m_depth = depth;
 			for (auto child : m_children)
-				child->m_parent = this;
+				if (auto* childTrans = get(child))
+					childTrans->setDepth(depth + 1);
+		}
 
-			this->setOrigin(tx.getOrigin());
-			this->setPosition(tx.getPosition());
-			this->setRotation(tx.getRotation());
-			this->setScale(tx.getScale());
+		void removeFromParent()
+		{
+			// direct, while the entity is destroyed it may not be found through the manager anymore
+			if (auto* parent = get(m_parent))
+				std::erase(parent->m_children, m_entity);
+			m_parent = ArkInvalidID;
+		}
 
-			tx.setPosition({0.f, 0.f});
-			tx.setRotation(0.f);
-			tx.setScale({1.f, 1.f});
-			tx.setOrigin({0.f, 0.f});
+		void orphanChildren()
+		{
+			for (auto child : m_children) {
+				if (auto* childTrans = get(child)) {
+					childTrans->m_parent = ArkInvalidID;
+					childTrans->setDepth(0);
+					childTrans->markDirty();
+				}
+			}
+			m_children.clear();
 		}
 
-		Transform* m_parent = nullptr;
-		std::vector<Transform*> m_children{};
-		//int m_depth;
+		ark::EntityManager* m_manager = nullptr; // set by onAdd
+		ark::EntityId m_entity = ArkInvalidID;
+		ark::EntityId m_parent = ArkInvalidID;
+		std::vector<ark::EntityId> m_children{};
+		int m_depth = 0;
+		mutable sf::Transform m_world;
+		mutable bool m_worldDirty = true;
+	};
+
+	/* Transformarile ordonate dupa adancime (parintii inaintea copiilor)
+	 * update() recalculeaza matricile world murdare intr-o singura trecere de sus in jos: fiecare e calculata o data,
+	 * din parintele deja actualizat. Dupa update() getWorldTransform() doar citeste cache-ul, deci poate fi apelat
+	 * din mai multe thread-uri (pana la urmatoarea modificare).
+	 * update() scrie cache-ul din Transform: sistemul care il apeleaza declara Transform ca scris
+	 * (declareAccess<ark::Transform>()), ca scheduler-ul sa nu-l ruleze in paralel cu alti cititori de Transform.
+	 * Transformarile murdare de aceeasi adancime au parintii gata calculati, deci fiecare nivel e un lot pentru
+	 * computeLocal/combine din TransformBatch.hpp.
+	*/
+	class TransformHierarchy {
+		ark::EntityQuery<const Transform> m_transforms;
+		std::vector<const Transform*> m_dirty;
+		ark::TRSBatch m_trs;
+		ark::AffineBatch m_parents;
+		ark::AffineBatch m_local;
+		ark::AffineBatch m_world;
+
+	public:
+		TransformHierarchy() = default;
+		explicit TransformHierarchy(ark::EntityManager& manager) { connect(manager); }
+
+		void connect(ark::EntityManager& manager)
+		{
+			m_transforms.connect(manager);
+			m_transforms.sort([man = &manager](ark::Entity a, ark::Entity b) {
+				return man->get<const Transform>(a).getDepth() < man->get<const Transform>(b).getDepth();
+			});
+		}
+
+		void update()
+		{
+			// adancimea se schimba doar la addChild/removeChild, lista e aproape mereu sortata
+			m_transforms.sort();
+			m_dirty.clear();
+			m_transforms.each([&](ark::Entity, const Transform& trans) {
+				if (trans.m_worldDirty)
+					m_dirty.push_back(&trans);
+			});
+
+			for (std::size_t begin = 0, end = 0; begin < m_dirty.size(); begin = end) {
+				const int depth = m_dirty[begin]->m_depth;
+				while (end < m_dirty.size() && m_dirty[end]->m_depth == depth)
+					end++;
+
+				const auto count = end - begin;
+				m_trs.resize(count);
+				m_parents.resize(count);
+				for (std::size_t i = 0; i < count; i++) {
+					const auto& trans = *m_dirty[begin + i];
+					m_trs.set(i, trans);
+					// parintele e curat: fie n-a fost murdar, fie e pe un nivel deja calculat
+					const auto* parent = trans.get(trans.m_parent);
+					m_parents.set(i, parent ? parent->m_world : sf::Transform::Identity);
+				}
+				ark::computeLocal(m_trs, m_local);
+				ark::combine(m_parents, m_local, m_world);
+				for (std::size_t i = 0; i < count; i++) {
+					const auto& trans = *m_dirty[begin + i];
+					trans.m_world = m_world.get(i);
+					trans.m_worldDirty = false;
+				}
+			}
+		}
 	};
 }
 
 ARK_REGISTER_COMPONENT_WITH_NAME_TAG(ark::Transform, "Transform", transform, addSerdeFunctions<ark::Transform>())
 {
 	auto* type = ark::meta::type<ark::Transform>();
+	type->data(ark::EntityManager::serviceOnAddName, ark::EntityManager::OnAddService{ ark::Transform::onAdd });
 	type->func(ark::serde::serviceSerializeName, ark::serde::serialize_value<ark::Transform>);
 	type->func(ark::serde::serviceDeserializeName, ark::serde::deserialize_value<ark::Transform>);
 	type->data(ark::SceneInspector::serviceOptions, std::vector<ark::EditorOptions>{
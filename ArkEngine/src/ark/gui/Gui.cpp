@@ -1,3 +1,5 @@
+#include <mutex>
+
 #include "ark/gui/Gui.hpp"
 #include "ark/core/Logger.hpp"
 #include "ark/util/ResourceManager.hpp"
@@ -117,6 +119,9 @@ namespace ark {
 
 	void InternalEngineLog(EngineLogData data)
 	{
+		// jobs log too (ex. serde::deserializeEntities)
+		static std::mutex s_mutex;
+		std::scoped_lock lock(s_mutex);
 #if USE_NATIVE_CONSOLE
 		std::string text = tfm::format("[%s] [%s]: %s\n", sourceToString(data.source).data(), levelToString(data.level).data(), data.text.c_str());
 		std::cout << text;
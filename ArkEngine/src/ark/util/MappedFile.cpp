@@ -0,0 +1,83 @@
+#include "ark/util/MappedFile.hpp"
+
+#if defined(_WIN32)
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+namespace ark {
+
+#if defined(_WIN32)
+	bool MappedFile::open(const std::string& path)
+	{
+		close();
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+		LARGE_INTEGER size{};
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+			CloseHandle(file);
+			return false;
+		}
+		// the mapping keeps the file open
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		CloseHandle(file);
+		if (!mapping)
+			return false;
+		void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (!view) {
+			CloseHandle(mapping);
+			return false;
+		}
+		m_data = static_cast<const std::byte*>(view);
+		m_size = static_cast<std::size_t>(size.QuadPart);
+		m_handle = mapping;
+		return true;
+	}
+
+	void MappedFile::close()
+	{
+		if (m_data)
+			UnmapViewOfFile(m_data);
+		if (m_handle)
+			CloseHandle(m_handle);
+		m_data = nullptr;
+		m_size = 0;
+		m_handle = nullptr;
+	}
+#else
+	bool MappedFile::open(const std::string& path)
+	{
+		close();
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd == -1)
+			return false;
+		struct stat st {};
+		if (fstat(fd, &st) != 0 || st.st_size == 0) {
+			::close(fd);
+			return false;
+		}
+		void* view = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);
+		if (view == MAP_FAILED)
+			return false;
+		m_data = static_cast<const std::byte*>(view);
+		m_size = static_cast<std::size_t>(st.st_size);
+		return true;
+	}
+
+	void MappedFile::close()
+	{
+		if (m_data)
+			munmap(const_cast<std::byte*>(m_data), m_size);
+		m_data = nullptr;
+		m_size = 0;
+	}
+#endif
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <cstddef>
+#include <utility>
+
+namespace ark {
+
+	/* Fisier mapat in memorie, read-only
+	 * view-ul e valid cat timp obiectul traieste; paginile sunt incarcate de OS la primul acces
+	*/
+	class MappedFile final {
+	public:
+		MappedFile() = default;
+		explicit MappedFile(const std::string& path) { open(path); }
+		~MappedFile() { close(); }
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		MappedFile(MappedFile&& other) noexcept
+			: m_data(std::exchange(other.m_data, nullptr)),
+			m_size(std::exchange(other.m_size, 0)),
+			m_handle(std::exchange(other.m_handle, nullptr))
+		{}
+
+		MappedFile& operator=(MappedFile&& other) noexcept
+		{
+			if (&other != this) {
+				close();
+				m_data = std::exchange(other.m_data, nullptr);
+				m_size = std::exchange(other.m_size, 0);
+				m_handle = std::exchange(other.m_handle, nullptr);
+			}
+			return *this;
+		}
+
+		// false if the file can't be opened or is empty
+		bool open(const std::string& path);
+		void close();
+
+		bool isOpen() const { return m_data != nullptr; }
+
+		// the start is page aligned
+		auto bytes() const -> std::span<const std::byte> { return { m_data, m_size }; }
+
+	private:
+		const std::byte* m_data = nullptr;
+		std::size_t m_size = 0;
+		void* m_handle = nullptr; // the mapping object on windows
+	};
+}
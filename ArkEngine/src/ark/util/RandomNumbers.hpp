@@ -1,6 +1,7 @@
 #pragma once
 
 #include <random>
+#include <atomic>
 #include "ark/ecs/Meta.hpp"
 #include "ark/ecs/DefaultServices.hpp"
 
@@ -54,6 +55,8 @@ namespace detail {
 			seed(rd);
 		}
 
+		explicit splitmix(uint64_t seed) : m_seed(seed) {}
+
 		void seed(std::random_device& rd) noexcept
 		{
 			m_seed = uint64_t(rd()) << 31 | uint64_t(rd());
@@ -198,8 +201,25 @@ namespace detail {
 }
 
 //static inline std::mt19937 __Random_Number_Generator__{ std::random_device()() };
-static inline std::random_device _ark_rng_device;
-static inline ::detail::splitmix __Random_Number_Generator__{_ark_rng_device};
+/* un generator per thread, RandomNumber e apelat si din View::par_each
+ * random_device e folosit o singura data, la initializarea statica; thread-urile nu il apeleaza concurent,
+ * fiecare primeste seed-ul global amestecat (splitmix64) cu indexul lui, luat dintr-un contor atomic
+*/
+inline const uint64_t _ark_rng_seed = []() {
+	std::random_device device;
+	return uint64_t(device()) << 32 | uint64_t(device());
+}();
+inline std::atomic<uint64_t> _ark_rng_threads = 0;
+
+inline uint64_t _ark_rng_thread_seed() noexcept
+{
+	uint64_t z = _ark_rng_seed + (_ark_rng_threads.fetch_add(1, std::memory_order_relaxed) + 1) * UINT64_C(0x9E3779B97F4A7C15);
+	z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+	z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+	return z ^ (z >> 31);
+}
+
+static inline thread_local ::detail::splitmix __Random_Number_Generator__{ _ark_rng_thread_seed() };
 
 template <typename T>
 static T RandomNumber(Distribution<T> arg) noexcept
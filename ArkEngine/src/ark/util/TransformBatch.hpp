@@ -0,0 +1,239 @@
+#pragma once
+
+#include <SFML/Graphics/Transform.hpp>
+#include <SFML/Graphics/Transformable.hpp>
+#include <SFML/Graphics/Rect.hpp>
+
+#include <vector>
+#include <span>
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+
+#if defined(__AVX2__)
+	#include <immintrin.h>
+	#define ARK_SIMD_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define ARK_SIMD_SSE2 1
+#endif
+
+/* Kernel-uri pe loturi de transformari 2D, tinute SoA (cate un vector pentru fiecare camp)
+ *
+ * computeLocal:   position/rotation/scale/origin -> matrice locala (aceeasi formula ca sf::Transformable::getTransform)
+ * combine:        parent * local -> world, element cu element
+ * transformRects: matrice * AABB local -> AABB world (ca sf::Transform::transformRect)
+ *
+ * Se proceseaza 8 (AVX2) sau 4 (SSE2) elemente deodata, restul pe calea scalara; fara /arch:AVX2 sau SSE2 totul e scalar.
+ * Setul de instructiuni se alege la compilare.
+*/
+
+namespace ark {
+
+	// x' = a * x + b * y + tx
+	// y' = c * x + d * y + ty
+	struct AffineBatch {
+		std::vector<float> a, b, c, d, tx, ty;
+
+		std::size_t size() const { return a.size(); }
+
+		void resize(std::size_t n)
+		{
+			a.resize(n); b.resize(n); c.resize(n); d.resize(n); tx.resize(n); ty.resize(n);
+		}
+
+		void set(std::size_t i, const sf::Transform& trans)
+		{
+			const float* m = trans.getMatrix(); // column major 4x4
+			a[i] = m[0]; b[i] = m[4]; tx[i] = m[12];
+			c[i] = m[1]; d[i] = m[5]; ty[i] = m[13];
+		}
+
+		sf::Transform get(std::size_t i) const
+		{
+			return sf::Transform(a[i], b[i], tx[i], c[i], d[i], ty[i], 0.f, 0.f, 1.f);
+		}
+	};
+
+	struct RectBatch {
+		std::vector<float> left, top, width, height;
+
+		std::size_t size() const { return left.size(); }
+
+		void resize(std::size_t n)
+		{
+			left.resize(n); top.resize(n); width.resize(n); height.resize(n);
+		}
+
+		void set(std::size_t i, sf::FloatRect rect)
+		{
+			left[i] = rect.left; top[i] = rect.top; width[i] = rect.width; height[i] = rect.height;
+		}
+
+		sf::FloatRect get(std::size_t i) const { return { left[i], top[i], width[i], height[i] }; }
+	};
+
+	// local position/rotation(degrees)/scale/origin
+	struct TRSBatch {
+		std::vector<float> posX, posY, rotation, scaleX, scaleY, originX, originY;
+
+		std::size_t size() const { return posX.size(); }
+
+		void resize(std::size_t n)
+		{
+			posX.resize(n); posY.resize(n); rotation.resize(n);
+			scaleX.resize(n); scaleY.resize(n); originX.resize(n); originY.resize(n);
+		}
+
+		void set(std::size_t i, const sf::Transformable& trans)
+		{
+			posX[i] = trans.getPosition().x; posY[i] = trans.getPosition().y;
+			rotation[i] = trans.getRotation();
+			scaleX[i] = trans.getScale().x; scaleY[i] = trans.getScale().y;
+			originX[i] = trans.getOrigin().x; originY[i] = trans.getOrigin().y;
+		}
+	};
+
+	namespace detail {
+
+		struct ScalarLane {
+			static constexpr std::size_t width = 1;
+			float v;
+
+			static ScalarLane load(const float* p) { return { *p }; }
+			static ScalarLane broadcast(float f) { return { f }; }
+			void store(float* p) const { *p = v; }
+
+			friend ScalarLane operator+(ScalarLane l, ScalarLane r) { return { l.v + r.v }; }
+			friend ScalarLane operator-(ScalarLane l, ScalarLane r) { return { l.v - r.v }; }
+			friend ScalarLane operator*(ScalarLane l, ScalarLane r) { return { l.v * r.v }; }
+			friend ScalarLane min(ScalarLane l, ScalarLane r) { return { std::min(l.v, r.v) }; }
+			friend ScalarLane max(ScalarLane l, ScalarLane r) { return { std::max(l.v, r.v) }; }
+		};
+
+#if defined(ARK_SIMD_AVX2)
+		struct WideLane {
+			static constexpr std::size_t width = 8;
+			__m256 v;
+
+			static WideLane load(const float* p) { return { _mm256_loadu_ps(p) }; }
+			static WideLane broadcast(float f) { return { _mm256_set1_ps(f) }; }
+			void store(float* p) const { _mm256_storeu_ps(p, v); }
+
+			friend WideLane operator+(WideLane l, WideLane r) { return { _mm256_add_ps(l.v, r.v) }; }
+			friend WideLane operator-(WideLane l, WideLane r) { return { _mm256_sub_ps(l.v, r.v) }; }
+			friend WideLane operator*(WideLane l, WideLane r) { return { _mm256_mul_ps(l.v, r.v) }; }
+			friend WideLane min(WideLane l, WideLane r) { return { _mm256_min_ps(l.v, r.v) }; }
+			friend WideLane max(WideLane l, WideLane r) { return { _mm256_max_ps(l.v, r.v) }; }
+		};
+#elif defined(ARK_SIMD_SSE2)
+		struct WideLane {
+			static constexpr std::size_t width = 4;
+			__m128 v;
+
+			static WideLane load(const float* p) { return { _mm_loadu_ps(p) }; }
+			static WideLane broadcast(float f) { return { _mm_set1_ps(f) }; }
+			void store(float* p) const { _mm_storeu_ps(p, v); }
+
+			friend WideLane operator+(WideLane l, WideLane r) { return { _mm_add_ps(l.v, r.v) }; }
+			friend WideLane operator-(WideLane l, WideLane r) { return { _mm_sub_ps(l.v, r.v) }; }
+			friend WideLane operator*(WideLane l, WideLane r) { return { _mm_mul_ps(l.v, r.v) }; }
+			friend WideLane min(WideLane l, WideLane r) { return { _mm_min_ps(l.v, r.v) }; }
+			friend WideLane max(WideLane l, WideLane r) { return { _mm_max_ps(l.v, r.v) }; }
+		};
+#else
+		using WideLane = ScalarLane;
+#endif
+
+		// kernel.template operator()<Lane>(i) for i, i + Lane::width, ... the tail goes through ScalarLane
+		template <typename F>
+		void forEachLane(std::size_t n, F&& kernel)
+		{
+			std::size_t i = 0;
+			if constexpr (WideLane::width > 1)
+				for (; i + WideLane::width <= n; i += WideLane::width)
+					kernel.template operator()<WideLane>(i);
+			for (; i < n; i++)
+				kernel.template operator()<ScalarLane>(i);
+		}
+	}
+
+	// sin/cos are scalar (no vector sin in SSE/AVX), the rest is vectorized
+	inline void computeLocal(const TRSBatch& in, AffineBatch& out)
+	{
+		const auto n = in.size();
+		out.resize(n);
+		// cos in 'a', sin in 'c' until the lane pass overwrites them
+		for (std::size_t i = 0; i < n; i++) {
+			const float angle = -in.rotation[i] * 3.141592654f / 180.f;
+			out.a[i] = std::cos(angle);
+			out.c[i] = std::sin(angle);
+		}
+		detail::forEachLane(n, [&]<typename L>(std::size_t i) {
+			const auto cosine = L::load(&out.a[i]);
+			const auto sine = L::load(&out.c[i]);
+			const auto sx = L::load(&in.scaleX[i]);
+			const auto sy = L::load(&in.scaleY[i]);
+			const auto ox = L::load(&in.originX[i]);
+			const auto oy = L::load(&in.originY[i]);
+			const auto sxc = sx * cosine;
+			const auto syc = sy * cosine;
+			const auto sxs = sx * sine;
+			const auto sys = sy * sine;
+			sxc.store(&out.a[i]);
+			sys.store(&out.b[i]);
+			(L::broadcast(0.f) - sxs).store(&out.c[i]);
+			syc.store(&out.d[i]);
+			(L::load(&in.posX[i]) - ox * sxc - oy * sys).store(&out.tx[i]);
+			(L::load(&in.posY[i]) + ox * sxs - oy * syc).store(&out.ty[i]);
+		});
+	}
+
+	// out = parent * local, out may be the same batch as parent or local
+	inline void combine(const AffineBatch& parent, const AffineBatch& local, AffineBatch& out)
+	{
+		const auto n = std::min(parent.size(), local.size());
+		out.resize(n);
+		detail::forEachLane(n, [&]<typename L>(std::size_t i) {
+			const auto pa = L::load(&parent.a[i]), pb = L::load(&parent.b[i]), pc = L::load(&parent.c[i]);
+			const auto pd = L::load(&parent.d[i]), ptx = L::load(&parent.tx[i]), pty = L::load(&parent.ty[i]);
+			const auto la = L::load(&local.a[i]), lb = L::load(&local.b[i]), lc = L::load(&local.c[i]);
+			const auto ld = L::load(&local.d[i]), ltx = L::load(&local.tx[i]), lty = L::load(&local.ty[i]);
+			(pa * la + pb * lc).store(&out.a[i]);
+			(pa * lb + pb * ld).store(&out.b[i]);
+			(pc * la + pd * lc).store(&out.c[i]);
+			(pc * lb + pd * ld).store(&out.d[i]);
+			(pa * ltx + pb * lty + ptx).store(&out.tx[i]);
+			(pc * ltx + pd * lty + pty).store(&out.ty[i]);
+		});
+	}
+
+	/* bounding box of the transformed rectangle, like sf::Transform::transformRect
+	 * min/max over the corners taken per term (Arvo): min(a*left, a*right) + min(b*top, b*bottom) + tx
+	*/
+	inline void transformRects(const AffineBatch& trans, const RectBatch& local, RectBatch& out)
+	{
+		const auto n = std::min(trans.size(), local.size());
+		out.resize(n);
+		detail::forEachLane(n, [&]<typename L>(std::size_t i) {
+			const auto l = L::load(&local.left[i]);
+			const auto t = L::load(&local.top[i]);
+			const auto r = l + L::load(&local.width[i]);
+			const auto btm = t + L::load(&local.height[i]);
+
+			const auto a = L::load(&trans.a[i]), b = L::load(&trans.b[i]);
+			const auto c = L::load(&trans.c[i]), d = L::load(&trans.d[i]);
+			const auto al = a * l, ar = a * r, bt = b * t, bb = b * btm;
+			const auto cl = c * l, cr = c * r, dt = d * t, db = d * btm;
+
+			const auto minX = min(al, ar) + min(bt, bb) + L::load(&trans.tx[i]);
+			const auto maxX = max(al, ar) + max(bt, bb) + L::load(&trans.tx[i]);
+			const auto minY = min(cl, cr) + min(dt, db) + L::load(&trans.ty[i]);
+			const auto maxY = max(cl, cr) + max(dt, db) + L::load(&trans.ty[i]);
+			minX.store(&out.left[i]);
+			minY.store(&out.top[i]);
+			(maxX - minX).store(&out.width[i]);
+			(maxY - minY).store(&out.height[i]);
+		});
+	}
+}